@@ -17,6 +17,7 @@ TARGET="--target install"
 CLEAN=false
 LIB_IMG_SHARED=false
 LIB_IMG_EXAMPLES=true
+LIB_IMG_TESTS=false
 
 CUDA_CPP_HOST_COMPILER="clang++-16"
 CUDA_C_HOST_COMPILER="clang-15"
@@ -24,6 +25,7 @@ CXX_COMPILER="clang++-16"
 C_COMPILER="clang-16"
 CUDA_ROOT_DIR="/usr/local/cuda"
 USE_TCMALLOC=false
+NATIVE_ARCH=false
 CMAKE_VERBOSE=""
 CMAKE_JOBS="-j"
 
@@ -38,6 +40,8 @@ print_help() {
   printf "  --cuda-cxx-compiler    Specify CUDA c++ HOST compiler. Default clang\n"
   printf "  --cuda-c-compiler      Specify CUDA c HOST  compiler. Default clang\n"
   printf "  --cuda-path            Specify CUDA toolkit path. Default \"/usr/local/cuda\"\n"
+  printf "  --tests                Build the tests, run them with ctest in the build folder.\n"
+  printf "  --native               Build for the host CPU (enables AVX2/SSSE3 kernels where available).\n"
   printf "  --target               NOT USED. specify target.\n"
   printf "  -j | --jobs            Allow N jobs at once\n"
   printf "  -h | --help            this help.\n"
@@ -59,6 +63,9 @@ for ((i = 0; i < $#; i++)); do
   --examples)
     LIB_IMG_EXAMPLES=true
     ;;
+  --tests)
+    LIB_IMG_TESTS=true
+    ;;
   --config)
     CONFIG=${opts[$((i + 1))]}
     ((i++))
@@ -93,6 +100,9 @@ for ((i = 0; i < $#; i++)); do
   --use-tcmalloc)
     USE_TCMALLOC=true
     ;;
+  --native)
+    NATIVE_ARCH=true
+    ;;
   --target)
     TARGET="--target ${opts[$((i + 1))]}"
     ((i++))
@@ -143,8 +153,10 @@ cmake -S $ROOT_DIR -B $BUILD_DIR \
   -D CMAKE_INSTALL_PREFIX=$INSTALL_PREFIX \
   -D CMAKE_EXPORT_COMPILE_COMMANDS:BOOL=true \
   -D LIB_IMG_USE_TCMALLOC:BOOL=$USE_TCMALLOC \
+  -D LIB_IMG_NATIVE_ARCH:BOOL=$NATIVE_ARCH \
   -D LIB_IMG_SHARED:BOOL=$LIB_IMG_SHARED \
-  -D LIB_IMG_EXAMPLES:BOOL=$LIB_IMG_EXAMPLES
+  -D LIB_IMG_EXAMPLES:BOOL=$LIB_IMG_EXAMPLES \
+  -D LIB_IMG_TESTS:BOOL=$LIB_IMG_TESTS
 if [[ $? -eq 1 ]]; then
   printf "${R}-- Cmake failed${W}\n" &&
     exit 1
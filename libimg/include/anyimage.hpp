@@ -0,0 +1,348 @@
+#ifndef LIB_IMG_ANY_IMAGE_H
+#define LIB_IMG_ANY_IMAGE_H
+
+#include <filesystem>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "common.hpp"
+#include "image.hpp"
+#include "img_assert.hpp"
+#include "pixel.hpp"
+#include "pixel_traits.hpp"
+#include "types.hpp"
+
+#include "stb_image.h"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    namespace detail {
+
+        // the pixel type a decode keeps without converting anything: grey stays grey, 16-bit samples stay 16-bit
+        // and radiance files stay float (stb always hands those out as rgb).
+        inline PixelFmt nativePixelFmt(int channels, bool is16Bit, bool isHdr) {
+            if (isHdr) {
+                return channels == 4 ? PF_HDRa32 : PF_HDR32;
+            }
+
+            constexpr PixelFmt FMT_8[4]  = {PF_GREY8, PF_GREYa8, PF_RGB8, PF_RGBa8};
+            constexpr PixelFmt FMT_16[4] = {PF_GREY16, PF_GREYa16, PF_RGB16, PF_RGBa16};
+            if (channels < 1 || channels > 4) {
+                return PF_UNKOWN;
+            }
+            return is16Bit ? FMT_16[channels - 1] : FMT_8[channels - 1];
+        }
+
+    } // namespace detail
+
+    // an image whose pixel type is picked at runtime, files load in their own channel layout and depth instead of
+    // being converted to whatever the caller compiled against. the typed image is held by value, `get<P>()` hands
+    // it out without a copy, operations are forwarded to it through one `std::visit` jump table over the pixel
+    // types below, each entry the same `Image<P>` member a typed caller would get.
+    class LIB_IMG_PUBLIC AnyImage {
+    public:
+        using Storage_t = std::variant<std::monostate,
+                                       Image<GREY8>,
+                                       Image<GREYa8>,
+                                       Image<RGB8>,
+                                       Image<RGBa8>,
+                                       Image<BGR8>,
+                                       Image<BGRa8>,
+                                       Image<GREY16>,
+                                       Image<GREYa16>,
+                                       Image<RGB16>,
+                                       Image<RGBa16>,
+                                       Image<HDR32>,
+                                       Image<HDRa32>>;
+
+    private:
+        // `fn(Image<P>&)` for the pixel type held, every entry has to return the same type.
+        template<typename Storage, typename Fn>
+        static decltype(auto) dispatch(Storage& storage, Fn&& fn) {
+            using First_t  = std::conditional_t<std::is_const_v<Storage>, const Image<GREY8>&, Image<GREY8>&>;
+            using Result_t = std::invoke_result_t<Fn, First_t>;
+            return std::visit(
+                [&](auto& image) -> Result_t {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(image)>, std::monostate>) {
+                        IMG_ABORT("null AnyImage");
+                    } else {
+                        return fn(image);
+                    }
+                },
+                storage);
+        }
+
+        // calls `fn.template operator()<Pixel>()` with the pixel type `pf` names.
+        template<typename Fn>
+        static AnyImage withPixelType(PixelFmt pf, Fn&& fn) {
+            switch (pf) {
+                case PF_GREY8: return fn.template operator()<GREY8>();
+                case PF_GREYa8: return fn.template operator()<GREYa8>();
+                case PF_RGB8: return fn.template operator()<RGB8>();
+                case PF_RGBa8: return fn.template operator()<RGBa8>();
+                case PF_BGR8: return fn.template operator()<BGR8>();
+                case PF_BGRa8: return fn.template operator()<BGRa8>();
+                case PF_GREY16: return fn.template operator()<GREY16>();
+                case PF_GREYa16: return fn.template operator()<GREYa16>();
+                case PF_RGB16: return fn.template operator()<RGB16>();
+                case PF_RGBa16: return fn.template operator()<RGBa16>();
+                case PF_HDR32: return fn.template operator()<HDR32>();
+                case PF_HDRa32: return fn.template operator()<HDRa32>();
+                case PF_UNKOWN: break;
+            }
+            IMG_ABORT("unsupported pixel format: %u", pf);
+        }
+
+    public:
+        AnyImage() = default;
+
+        template<typename Pixel>
+        AnyImage(Image<Pixel>&& image) {
+            if (!image.isNull()) {
+                m_image.emplace<Image<Pixel>>(std::move(image));
+            }
+        }
+
+        AnyImage(const fs::path& filePath) : AnyImage() {
+            if (!fs::exists(filePath)) {
+                IMG_ABORT("file does not exist: %s", filePath.c_str());
+            }
+
+            *this = tryLoad(filePath);
+            if (isNull()) {
+                IMG_ABORT("stb couldn't load image file: %s", filePath.c_str());
+            }
+        }
+
+        // same as `AnyImage(filePath)` but returns a null image instead of aborting when the file can't be decoded.
+        // the file is read once, probing its format and decoding it both work on the bytes in memory.
+        [[nodiscard]] static AnyImage tryLoad(const fs::path& filePath) {
+            return tryLoad(detail::readFile(filePath));
+        }
+
+        // decodes an in-memory encoded file, returns a null image on failure.
+        [[nodiscard]] static AnyImage tryLoad(std::span<const u8> encoded) {
+            const int size = static_cast<int>(encoded.size());
+
+            int w, h, c;
+            if (!stbi_info_from_memory(encoded.data(), size, &w, &h, &c)) {
+                return {};
+            }
+
+            const PixelFmt pf = detail::nativePixelFmt(c,
+                                                       stbi_is_16_bit_from_memory(encoded.data(), size),
+                                                       stbi_is_hdr_from_memory(encoded.data(), size));
+            if (pf == PF_UNKOWN) {
+                return {};
+            }
+            return withPixelType(pf, [&]<typename Pixel>() { return AnyImage{Image<Pixel>::tryLoad(encoded)}; });
+        }
+
+        // zero filled.
+        [[nodiscard]] static AnyImage creatBlankImage(u32 width, u32 height, PixelFmt pf) {
+            return withPixelType(pf, [&]<typename Pixel>() {
+                return AnyImage{Image<Pixel>::creatBlankImage(width, height, pf)};
+            });
+        }
+
+        bool isNull() const {
+            return m_image.index() == 0;
+        }
+
+        PixelFmt format() const {
+            return isNull() ? PF_UNKOWN : dispatch(m_image, [](const auto& image) {
+                return pixel_traits<typename std::decay_t<decltype(image)>::Pixel_t>::FORMAT;
+            });
+        }
+
+        u32 width() const {
+            return isNull() ? 0 : dispatch(m_image, [](const auto& image) { return image.width(); });
+        }
+
+        u32 height() const {
+            return isNull() ? 0 : dispatch(m_image, [](const auto& image) { return image.height(); });
+        }
+
+        u32 chanelCount() const {
+            return isNull() ? 0 : dispatch(m_image, [](const auto& image) { return image.chanelCount(); });
+        }
+
+        // bits per channel: 8, 16 or 32 (float).
+        u32 bitDepth() const {
+            return isNull() ? 0 : dispatch(m_image, [](const auto& image) {
+                return static_cast<u32>(sizeof(typename std::decay_t<decltype(image)>::Channel_t) * 8);
+            });
+        }
+
+        u32 pixelCount() const {
+            return isNull() ? 0 : dispatch(m_image, [](const auto& image) { return image.pixelCount(); });
+        }
+
+        // the typed image if this holds `Pixel`s, otherwise nullptr.
+        template<typename Pixel>
+        Image<Pixel>* get() {
+            return std::get_if<Image<Pixel>>(&m_image);
+        }
+
+        template<typename Pixel>
+        const Image<Pixel>* get() const {
+            return std::get_if<Image<Pixel>>(&m_image);
+        }
+
+        // moves the typed image out, this is null afterwards. aborts if it doesn't hold `Pixel`s.
+        template<typename Pixel>
+        [[nodiscard]] Image<Pixel> take() {
+            Image<Pixel>* image = get<Pixel>();
+            IMG_ASSERT(image,
+                       "pixel format mismatch: %s image taken as %s",
+                       pixelFmtName(format()),
+                       pixelFmtName(pixel_traits<Pixel>::FORMAT));
+
+            Image<Pixel> out = std::move(*image);
+            m_image.emplace<std::monostate>();
+            return out;
+        }
+
+        // calls `fn(Image<P>&)` with the typed image, `fn` has to accept every pixel type. aborts on a null image.
+        template<typename Fn>
+        decltype(auto) visit(Fn&& fn) {
+            return dispatch(m_image, std::forward<Fn>(fn));
+        }
+
+        template<typename Fn>
+        decltype(auto) visit(Fn&& fn) const {
+            return dispatch(m_image, std::forward<Fn>(fn));
+        }
+
+        bool save(const fs::path& filePath, bool png_for_unsupported_format = true) const {
+            return visit([&](const auto& image) { return image.save(filePath, png_for_unsupported_format); });
+        }
+
+        [[nodiscard]] std::vector<u8> encode(const fs::path& filePath) const {
+            return visit([&](const auto& image) { return image.encode(filePath); });
+        }
+
+        AnyImage& flipX() {
+            visit([](auto& image) { image.flipX(); });
+            return *this;
+        }
+
+        AnyImage& flipY() {
+            visit([](auto& image) { image.flipY(); });
+            return *this;
+        }
+
+        AnyImage& rotateRight() {
+            visit([](auto& image) { image.rotateRight(); });
+            return *this;
+        }
+
+        AnyImage& rotateLeft() {
+            visit([](auto& image) { image.rotateLeft(); });
+            return *this;
+        }
+
+        AnyImage& orient(Orientation orientation) {
+            visit([&](auto& image) { image.orient(orientation); });
+            return *this;
+        }
+
+        AnyImage& materialize() {
+            visit([](auto& image) { image.materialize(); });
+            return *this;
+        }
+
+        AnyImage& crop(u32 x1, u32 y1, u32 x2, u32 y2, bool shrinkToFit = false) {
+            visit([&](auto& image) { image.crop(x1, y1, x2, y2, shrinkToFit); });
+            return *this;
+        }
+
+        AnyImage& cropZeroBased(u32 x0, u32 y0, u32 x1, u32 y1, bool shrinkToFit = false) {
+            visit([&](auto& image) { image.cropZeroBased(x0, y0, x1, y1, shrinkToFit); });
+            return *this;
+        }
+
+        // the kernels below only exist for some pixel types, the others abort.
+
+        AnyImage& erode(u32 kernelWidth, u32 kernelHeight) {
+            visit([&](auto& image) {
+                if constexpr (requires { image.erode(kernelWidth, kernelHeight); }) {
+                    image.erode(kernelWidth, kernelHeight);
+                } else {
+                    unsupported("erode");
+                }
+            });
+            return *this;
+        }
+
+        AnyImage& dilate(u32 kernelWidth, u32 kernelHeight) {
+            visit([&](auto& image) {
+                if constexpr (requires { image.dilate(kernelWidth, kernelHeight); }) {
+                    image.dilate(kernelWidth, kernelHeight);
+                } else {
+                    unsupported("dilate");
+                }
+            });
+            return *this;
+        }
+
+        AnyImage& medianBlur(u32 radius) {
+            visit([&](auto& image) {
+                if constexpr (requires { image.medianBlur(radius); }) {
+                    image.medianBlur(radius);
+                } else {
+                    unsupported("medianBlur");
+                }
+            });
+            return *this;
+        }
+
+        AnyImage& colorMask(float r, float g, float b) {
+            visit([&](auto& image) {
+                if constexpr (requires { image.colorMask(r, g, b); }) {
+                    image.colorMask(r, g, b);
+                } else {
+                    unsupported("colorMask");
+                }
+            });
+            return *this;
+        }
+
+        // grey images come back as a copy, colour ones as the grey type of the same depth and alpha.
+        [[nodiscard]] AnyImage greyScaleLum() const {
+            return visit([](const auto& image) {
+                if constexpr (requires { image.greyScaleLum(); }) {
+                    return AnyImage{image.greyScaleLum()};
+                } else {
+                    return AnyImage{std::decay_t<decltype(image)>{image}};
+                }
+            });
+        }
+
+        [[nodiscard]] AnyImage greyScaleAvg() const {
+            return visit([](const auto& image) {
+                if constexpr (requires { image.greyScaleAvg(); }) {
+                    return AnyImage{image.greyScaleAvg()};
+                } else {
+                    return AnyImage{std::decay_t<decltype(image)>{image}};
+                }
+            });
+        }
+
+    private:
+        [[noreturn]] void unsupported(const char* op) const {
+            IMG_ABORT("%s isn't supported on %s images", op, pixelFmtName(format()));
+        }
+
+    private:
+        Storage_t m_image;
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_ANY_IMAGE_H
@@ -0,0 +1,359 @@
+#ifndef LIB_IMG_ASYNC_H
+#define LIB_IMG_ASYNC_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "image.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    // lazily started coroutine result, `co_await` it from another coroutine or block on it with `get()`.
+    template<typename T>
+    class [[nodiscard]] Task {
+    public:
+        struct promise_type;
+        using Handle = std::coroutine_handle<promise_type>;
+
+    private:
+        struct SyncState {
+            std::atomic<bool> done{false};
+        };
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(Handle h) noexcept {
+                if (h.promise().continuation) {
+                    return h.promise().continuation;
+                }
+
+                // keep the state alive on this stack, the waiter may destroy the frame as soon as it sees `done`.
+                std::shared_ptr<SyncState> state = h.promise().syncState;
+                state->done.store(true, std::memory_order_release);
+                state->done.notify_all();
+                return std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {
+            }
+        };
+
+    public:
+        struct promise_type {
+            std::optional<T>           value;
+            std::coroutine_handle<>    continuation;
+            std::shared_ptr<SyncState> syncState;
+
+            Task get_return_object() {
+                return Task{Handle::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() noexcept {
+                return {};
+            }
+
+            void return_value(T v) {
+                value.emplace(std::move(v));
+            }
+
+            void unhandled_exception() {
+                std::terminate();
+            }
+        };
+
+        Task(Task&& other) noexcept : m_h(std::exchange(other.m_h, nullptr)) {
+        }
+
+        Task(const Task&)            = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            if (m_h) {
+                m_h.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+            m_h.promise().continuation = continuation;
+            return m_h;
+        }
+
+        T await_resume() {
+            return std::move(*m_h.promise().value);
+        }
+
+        // runs the task and blocks the calling thread until it completes.
+        T get() {
+            auto state              = std::make_shared<SyncState>();
+            m_h.promise().syncState = state;
+            m_h.resume();
+            state->done.wait(false, std::memory_order_acquire);
+            return std::move(*m_h.promise().value);
+        }
+
+    private:
+        explicit Task(Handle h) : m_h(h) {
+        }
+
+    private:
+        Handle m_h;
+    };
+
+    // `co_await schedule(pool)` moves the rest of the coroutine onto a thread of `pool`.
+    inline auto schedule(ThreadPool& pool) {
+        struct ScheduleAwaiter {
+            ThreadPool& pool;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> h) {
+                pool.submit([h] { h.resume(); });
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+
+        return ScheduleAwaiter{pool};
+    }
+
+    // counting semaphore that suspends the awaiting coroutine instead of blocking its thread.
+    class LIB_IMG_PUBLIC AsyncSemaphore {
+    public:
+        explicit AsyncSemaphore(u32 count) : m_count(count) {
+        }
+
+        auto acquire() {
+            struct AcquireAwaiter {
+                AsyncSemaphore& sem;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> h) {
+                    std::lock_guard lock{sem.m_mutex};
+                    if (sem.m_count > 0) {
+                        --sem.m_count;
+                        return false;
+                    }
+                    sem.m_waiters.push_back(h);
+                    return true;
+                }
+
+                void await_resume() const noexcept {
+                }
+            };
+
+            return AcquireAwaiter{*this};
+        }
+
+        // hands the permit straight to the oldest waiter, if any, and resumes it on this thread.
+        void release() {
+            std::unique_lock lock{m_mutex};
+            if (m_waiters.empty()) {
+                ++m_count;
+                return;
+            }
+
+            std::coroutine_handle<> next = m_waiters.front();
+            m_waiters.pop_front();
+            lock.unlock();
+            next.resume();
+        }
+
+    private:
+        std::mutex                          m_mutex;
+        u32                                 m_count;
+        std::deque<std::coroutine_handle<>> m_waiters;
+    };
+
+    // shared flag checked between the I/O and codec stages, copies observe the same cancellation.
+    class LIB_IMG_PUBLIC CancellationToken {
+    public:
+        CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {
+        }
+
+        void cancel() const {
+            m_cancelled->store(true, std::memory_order_relaxed);
+        }
+
+        bool cancelled() const {
+            return m_cancelled->load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_cancelled;
+    };
+
+    // runs file reads/writes on a small dedicated I/O pool and decoding/encoding on a separate codec pool, with
+    // at most `maxInFlight` loads and saves running at once, extra requests wait without holding a thread.
+    class LIB_IMG_PUBLIC AsyncImageIO {
+    public:
+        explicit AsyncImageIO(u32 ioThreads   = 2,
+                              u32 codecThreads = std::max(1u, std::thread::hardware_concurrency()),
+                              u32 maxInFlight  = 64)
+            : m_inFlight(maxInFlight),
+              m_io(ioThreads),
+              m_codec(codecThreads) {
+            IMG_ASSERT(ioThreads > 0 && codecThreads > 0 && maxInFlight > 0,
+                       "async image I/O needs at least one thread per executor and one in-flight slot");
+        }
+
+        AsyncImageIO(const AsyncImageIO&)            = delete;
+        AsyncImageIO& operator=(const AsyncImageIO&) = delete;
+
+        // a load or save hops between both pools, whichever is destroyed first could still be scheduled onto by a
+        // task of the other. the pools are only torn down once every started operation has made its last hop.
+        ~AsyncImageIO() {
+            std::unique_lock lock{m_runningMutex};
+            m_runningDone.wait(lock, [this] { return m_running == 0; });
+        }
+
+        ThreadPool& ioExecutor() {
+            return m_io;
+        }
+
+        ThreadPool& codecExecutor() {
+            return m_codec;
+        }
+
+        // resolves to a null image if the file can't be read or decoded, or if `token` was cancelled.
+        template<typename Pixel>
+        Task<Image<Pixel>> loadAsync(fs::path filePath, CancellationToken token = {}) {
+            RunningOperation running{*this};
+            Image<Pixel>     image;
+            {
+                co_await m_inFlight.acquire();
+                InFlightPermit permit{m_inFlight};
+                // from read to decoded, closed before `image` is moved out on whichever thread the load ends.
+                IMG_TRACE_SCOPE("loadAsync", image);
+
+                co_await schedule(m_io);
+                if (token.cancelled()) {
+                    co_return Image<Pixel>{};
+                }
+
+                std::vector<u8> encoded = detail::readFile(filePath);
+                if (encoded.empty()) {
+                    co_return Image<Pixel>{};
+                }
+
+                co_await schedule(m_codec);
+                if (token.cancelled()) {
+                    co_return Image<Pixel>{};
+                }
+
+                image = Image<Pixel>::tryLoad(encoded);
+            }
+            co_return image;
+        }
+
+        // takes the image by value so callers can move it in, resolves to false on failure or cancellation.
+        template<typename Pixel>
+        Task<bool> saveAsync(Image<Pixel> image, fs::path filePath, CancellationToken token = {}) {
+            RunningOperation running{*this};
+            co_await m_inFlight.acquire();
+            InFlightPermit permit{m_inFlight};
+            // from encode to written, recorded on whichever thread the save ends.
+            IMG_TRACE_SCOPE("saveAsync", image);
+
+            co_await schedule(m_codec);
+            if (token.cancelled()) {
+                co_return false;
+            }
+
+            std::vector<u8> encoded = image.encode(filePath);
+            if (encoded.empty()) {
+                co_return false;
+            }
+
+            co_await schedule(m_io);
+            if (token.cancelled()) {
+                co_return false;
+            }
+
+            co_return writeFile(filePath, encoded);
+        }
+
+    private:
+        // counts the operation from its first line to its end, on whichever thread that happens. notifies under
+        // the lock, the destructor can return as soon as it sees the count drop.
+        struct RunningOperation {
+            AsyncImageIO& io;
+
+            explicit RunningOperation(AsyncImageIO& owner) : io(owner) {
+                std::lock_guard lock{io.m_runningMutex};
+                ++io.m_running;
+            }
+
+            ~RunningOperation() {
+                std::lock_guard lock{io.m_runningMutex};
+                if (--io.m_running == 0) {
+                    io.m_runningDone.notify_all();
+                }
+            }
+        };
+
+        struct InFlightPermit {
+            AsyncSemaphore& sem;
+
+            ~InFlightPermit() {
+                sem.release();
+            }
+        };
+
+        static bool writeFile(const fs::path& filePath, const std::vector<u8>& bytes) {
+            FILE* f = fopen(filePath.c_str(), "wb");
+            if (!f) {
+                return false;
+            }
+
+            const bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+            return (fclose(f) == 0) && ok;
+        }
+
+    private:
+        std::mutex              m_runningMutex;
+        std::condition_variable m_runningDone;
+        u64                     m_running = 0;
+
+        // declared first so it outlives the pools, whose last tasks may still release permits while joining.
+        AsyncSemaphore m_inFlight;
+        ThreadPool     m_io;
+        ThreadPool     m_codec;
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_ASYNC_H
@@ -0,0 +1,149 @@
+#ifndef LIB_IMG_BORDER_H
+#define LIB_IMG_BORDER_H
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "common.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // how samples outside the image are resolved, shown for a row `abcdefgh`.
+    enum BorderMode : u8 {
+        BM_CONSTANT    = 0, // iiii|abcdefgh|iiii  a caller supplied colour
+        BM_REPLICATE   = 1, // aaaa|abcdefgh|hhhh
+        BM_REFLECT     = 2, // dcba|abcdefgh|hgfe
+        BM_REFLECT_101 = 3, // edcb|abcdefgh|gfed
+        BM_WRAP        = 4, // efgh|abcdefgh|abcd
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    // maps coordinate `i` onto `[0, n)`, -1 means the sample takes the constant border colour.
+    inline i64 borderIndex(i64 i, i64 n, BorderMode mode) {
+        if (static_cast<u64>(i) < static_cast<u64>(n)) {
+            return i;
+        }
+
+        auto wrap = [](i64 v, i64 period) {
+            const i64 r = v % period;
+            return r < 0 ? r + period : r;
+        };
+
+        switch (mode) {
+            case BM_REPLICATE: return i < 0 ? 0 : n - 1;
+            case BM_REFLECT: {
+                const i64 r = wrap(i, 2 * n);
+                return r < n ? r : 2 * n - 1 - r;
+            }
+            case BM_REFLECT_101: {
+                if (n == 1) {
+                    return 0;
+                }
+                const i64 r = wrap(i, 2 * n - 2);
+                return r < n ? r : 2 * n - 2 - r;
+            }
+            case BM_WRAP: return wrap(i, n);
+            case BM_CONSTANT: break;
+        }
+        return -1;
+    }
+
+    // `n` copies of the `size` byte pixel `px`, copying the already written prefix so the calls double in length.
+    inline void fillPixels(u8* out, const u8* px, std::size_t n, std::size_t size) {
+        if (n == 0) {
+            return;
+        }
+
+        std::memcpy(out, px, size);
+        for (std::size_t done = 1; done < n;) {
+            const std::size_t len = std::min(done, n - done);
+            std::memcpy(out + done * size, out, len * size);
+            done += len;
+        }
+    }
+
+    // fills `left` pixels before and `right` pixels after a row of `width` pixels already sitting at
+    // `row + left * size`. columns come from the row itself, each mode is a copy loop of its own with no per
+    // pixel bounds test.
+    inline void extendRow(u8* row, u32 width, std::size_t size, u32 left, u32 right, BorderMode mode,
+                          const u8* constant) {
+        u8* first = row + std::size_t{left} * size;
+        u8* end   = first + std::size_t{width} * size;
+
+        if (mode == BM_CONSTANT) {
+            fillPixels(row, constant, left, size);
+            fillPixels(end, constant, right, size);
+            return;
+        }
+        if (mode == BM_REPLICATE) {
+            fillPixels(row, first, left, size);
+            fillPixels(end, end - size, right, size);
+            return;
+        }
+
+        // the mirrored and wrapped modes repeat with a period of at most 2 * width, map each column once.
+        for (u32 p = 1; p <= left; ++p) {
+            std::memcpy(first - p * size, first + borderIndex(-i64{p}, width, mode) * size, size);
+        }
+        for (u32 p = 0; p < right; ++p) {
+            std::memcpy(end + p * size, first + borderIndex(i64{width} + p, width, mode) * size, size);
+        }
+    }
+
+} // namespace img::detail
+
+namespace img {
+
+    // a packed image seen as if it continued past its edges according to `mode`, nothing is padded. filters
+    // split their loops with `interior()`, read the source in place there and only resolve borders (through `at()`,
+    // `row()` or a clamp of their own) in the strips outside it.
+    struct BorderedView {
+        const u8*   data;
+        u32         width;
+        u32         height;
+        std::size_t pixelSize;
+        BorderMode  mode;
+        const u8*   constant; // `pixelSize` bytes, read with BM_CONSTANT
+
+        // [begin, end) of the positions along an axis of `n` where a window reaching `before` pixels back and
+        // `after` pixels ahead stays inside, empty when the window is wider than the axis.
+        static std::pair<u32, u32> interior(u32 n, u32 before, u32 after) {
+            const u32 end = n > after ? n - after : 0;
+            return {std::min(before, end), end};
+        }
+
+        const u8* at(i64 x, i64 y) const {
+            if (static_cast<u64>(x) < width && static_cast<u64>(y) < height) {
+                return data + (static_cast<std::size_t>(y) * width + static_cast<std::size_t>(x)) * pixelSize;
+            }
+
+            const i64 bx = detail::borderIndex(x, width, mode);
+            const i64 by = detail::borderIndex(y, height, mode);
+            if (bx < 0 || by < 0) {
+                return constant;
+            }
+            return data + (static_cast<std::size_t>(by) * width + static_cast<std::size_t>(bx)) * pixelSize;
+        }
+
+        // writes row `y` with `left` and `right` border pixels into `out`, (left + width + right) * pixelSize bytes.
+        void row(i64 y, u8* out, u32 left, u32 right) const {
+            const i64 by = detail::borderIndex(y, height, mode);
+            if (by < 0) {
+                detail::fillPixels(out, constant, std::size_t{left} + width + right, pixelSize);
+                return;
+            }
+
+            const std::size_t rowBytes = std::size_t{width} * pixelSize;
+            std::memcpy(out + left * pixelSize, data + static_cast<std::size_t>(by) * rowBytes, rowBytes);
+            detail::extendRow(out, width, pixelSize, left, right, mode, constant);
+        }
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_BORDER_H
@@ -0,0 +1,202 @@
+#ifndef LIB_IMG_CACHE_H
+#define LIB_IMG_CACHE_H
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "image.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    struct ImageCacheStats {
+        u64 hits;
+        u64 misses;
+        u64 evictions;
+        u64 bytes;
+        u64 entries;
+    };
+
+    // LRU cache of decoded images keyed by path, modification time and file size, so a rewritten file is a
+    // new key. images are handed out as shared read-only handles that outlive eviction, and concurrent
+    // requests for a key that is still decoding wait for that single decode instead of starting their own.
+    template<typename Pixel>
+    class LIB_IMG_PUBLIC ImageCache {
+        struct Key {
+            std::string path;
+            i64         mtime;
+            u64         size;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key& k) const {
+                std::size_t h = std::hash<std::string>{}(k.path);
+                h ^= std::hash<i64>{}(k.mtime) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+                h ^= std::hash<u64>{}(k.size) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+                return h;
+            }
+        };
+
+    public:
+        using Handle = std::shared_ptr<const Image<Pixel>>;
+
+    private:
+        struct Entry {
+            Key                        key;
+            std::shared_future<Handle> image;
+            u64                        bytes;
+            bool                       ready;
+        };
+
+        using LruIterator = typename std::list<Entry>::iterator;
+
+    public:
+        explicit ImageCache(u64 byteBudget) : m_budget(byteBudget) {
+        }
+
+        ImageCache(const ImageCache&)            = delete;
+        ImageCache& operator=(const ImageCache&) = delete;
+
+        // returns a null handle if the file is missing or can't be decoded, failures are not cached. an exception
+        // thrown by the decode reaches every caller waiting on it.
+        [[nodiscard]] Handle get(const fs::path& filePath) {
+            std::error_code ec;
+            const auto      mtime = fs::last_write_time(filePath, ec);
+            if (ec) {
+                return nullptr;
+            }
+            const auto size = fs::file_size(filePath, ec);
+            if (ec) {
+                return nullptr;
+            }
+
+            Key key{
+                .path  = filePath.lexically_normal().string(),
+                .mtime = mtime.time_since_epoch().count(),
+                .size  = size,
+            };
+
+            std::unique_lock lock{m_mutex};
+
+            if (auto it = m_index.find(key); it != m_index.end()) {
+                ++m_hits;
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                std::shared_future<Handle> image = it->second->image;
+                lock.unlock();
+                return image.get();
+            }
+
+            ++m_misses;
+
+            std::promise<Handle> promise;
+            m_lru.push_front(Entry{.key = key, .image = promise.get_future().share(), .bytes = 0, .ready = false});
+            m_index.emplace(std::move(key), m_lru.begin());
+            // pending entries are skipped by `evict()` and `clear()`, so this iterator stays valid.
+            const LruIterator pending = m_lru.begin();
+            lock.unlock();
+
+            // a throwing decode (`std::bad_alloc` from stb's buffer) is handed to the waiters and the entry dropped,
+            // a pending entry left behind would never be evicted.
+            u64    bytes = 0;
+            Handle image;
+            try {
+                Image<Pixel> decoded = Image<Pixel>::tryLoad(filePath);
+                bytes                = u64{decoded.pixelCount()} * sizeof(Pixel);
+                if (!decoded.isNull()) {
+                    image = std::make_shared<const Image<Pixel>>(std::move(decoded));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+                lock.lock();
+                m_index.erase(pending->key);
+                m_lru.erase(pending);
+                throw;
+            }
+            promise.set_value(image);
+
+            lock.lock();
+            if (image) {
+                pending->bytes = bytes;
+                pending->ready = true;
+                m_bytes += bytes;
+                evict();
+            } else {
+                m_index.erase(pending->key);
+                m_lru.erase(pending);
+            }
+
+            return image;
+        }
+
+        void setBudget(u64 byteBudget) {
+            std::lock_guard lock{m_mutex};
+            m_budget = byteBudget;
+            evict();
+        }
+
+        // drops every decoded entry, handles already given out stay valid.
+        void clear() {
+            std::lock_guard lock{m_mutex};
+            for (auto it = m_lru.begin(); it != m_lru.end();) {
+                if (it->ready) {
+                    m_bytes -= it->bytes;
+                    m_index.erase(it->key);
+                    it = m_lru.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        [[nodiscard]] ImageCacheStats stats() const {
+            std::lock_guard lock{m_mutex};
+            return {
+                .hits      = m_hits,
+                .misses    = m_misses,
+                .evictions = m_evictions,
+                .bytes     = m_bytes,
+                .entries   = m_index.size(),
+            };
+        }
+
+    private:
+        void evict() {
+            for (auto it = m_lru.end(); m_bytes > m_budget && it != m_lru.begin();) {
+                --it;
+                if (!it->ready) {
+                    continue;
+                }
+                m_bytes -= it->bytes;
+                m_index.erase(it->key);
+                it = m_lru.erase(it);
+                ++m_evictions;
+            }
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+
+        std::list<Entry>                              m_lru;
+        std::unordered_map<Key, LruIterator, KeyHash> m_index;
+
+        u64 m_budget;
+        u64 m_bytes     = 0;
+        u64 m_hits      = 0;
+        u64 m_misses    = 0;
+        u64 m_evictions = 0;
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_CACHE_H
@@ -0,0 +1,357 @@
+#ifndef LIB_IMG_COLOR_H
+#define LIB_IMG_COLOR_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+#include "common.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    enum YCbCrMatrix : u8 {
+        YCC_BT601 = 0, // SD video and JPEG
+        YCC_BT709 = 1, // HD video
+    };
+
+    enum YCbCrRange : u8 {
+        YCC_FULL_RANGE    = 0, // Y, Cb, Cr in [0, 255], what JPEG uses
+        YCC_LIMITED_RANGE = 1, // Y in [16, 235], Cb and Cr in [16, 240]
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    // conversions run in place on packed 3-byte pixels, `order` gives the byte offsets of the first, second and
+    // third component (r, g, b for RGB8, reversed for BGR8), converted components go back to the same offsets.
+    // 8-bit encodings: hue covers a full turn in 256 steps, saturation/value/lightness are 0 .. 255, Lab is
+    // L * 255 / 100, a + 128, b + 128.
+    using ChannelOrder = std::array<u32, 3>;
+
+    constexpr i32 COLOR_SHIFT = 13;
+
+    // out[k] = sat((sum_j m[k][j] * in[j] + bias[k]) >> COLOR_SHIFT), every coefficient fits 16 bits.
+    struct ColorMatrix {
+        i16 m[3][3];
+        i32 bias[3];
+    };
+
+    // fixed point form of out = M (in - inOffset) + outOffset, rounded to nearest.
+    inline ColorMatrix makeColorMatrix(const double (&m)[3][3], const double (&inOffset)[3],
+                                       const double (&outOffset)[3]) {
+        ColorMatrix cm{};
+        for (u32 k = 0; k < 3; ++k) {
+            double bias = outOffset[k];
+            for (u32 j = 0; j < 3; ++j) {
+                cm.m[k][j] = static_cast<i16>(std::lround(m[k][j] * (1 << COLOR_SHIFT)));
+                bias -= m[k][j] * inOffset[j];
+            }
+            cm.bias[k] = static_cast<i32>(std::lround(bias * (1 << COLOR_SHIFT))) + (1 << (COLOR_SHIFT - 1));
+        }
+        return cm;
+    }
+
+    // rows of the RGB -> YCbCr matrix for luma weights kr/kb, chroma scaled to +-0.5 of the range. an 8-bit round
+    // trip through it and `yCbCrInverse()` is off by at most 1 step full range and 2 limited range.
+    inline ColorMatrix yCbCrForward(YCbCrMatrix matrix, YCbCrRange range) {
+        const double kr = matrix == YCC_BT709 ? 0.2126 : 0.299;
+        const double kb = matrix == YCC_BT709 ? 0.0722 : 0.114;
+        const double kg = 1.0 - kr - kb;
+        const double ys = range == YCC_LIMITED_RANGE ? 219.0 / 255.0 : 1.0;
+        const double cs = range == YCC_LIMITED_RANGE ? 224.0 / 255.0 : 1.0;
+        const double cb = cs / (2.0 * (1.0 - kb));
+        const double cr = cs / (2.0 * (1.0 - kr));
+
+        const double m[3][3] = {
+            {ys * kr, ys * kg, ys * kb},
+            {-cb * kr, -cb * kg, cb * (1.0 - kb)},
+            {cr * (1.0 - kr), -cr * kg, -cr * kb},
+        };
+        return makeColorMatrix(m, {0, 0, 0}, {range == YCC_LIMITED_RANGE ? 16.0 : 0.0, 128.0, 128.0});
+    }
+
+    inline ColorMatrix yCbCrInverse(YCbCrMatrix matrix, YCbCrRange range) {
+        const double kr = matrix == YCC_BT709 ? 0.2126 : 0.299;
+        const double kb = matrix == YCC_BT709 ? 0.0722 : 0.114;
+        const double kg = 1.0 - kr - kb;
+        const double ys = range == YCC_LIMITED_RANGE ? 255.0 / 219.0 : 1.0;
+        const double cs = range == YCC_LIMITED_RANGE ? 255.0 / 224.0 : 1.0;
+
+        const double m[3][3] = {
+            {ys, 0.0, cs * 2.0 * (1.0 - kr)},
+            {ys, -cs * 2.0 * kb * (1.0 - kb) / kg, -cs * 2.0 * kr * (1.0 - kr) / kg},
+            {ys, cs * 2.0 * (1.0 - kb), 0.0},
+        };
+        return makeColorMatrix(m, {range == YCC_LIMITED_RANGE ? 16.0 : 0.0, 128.0, 128.0}, {0, 0, 0});
+    }
+
+    inline u8 applyColorMatrix(const ColorMatrix& cm, u32 k, i32 a, i32 b, i32 c) {
+        const i32 v = (cm.m[k][0] * a + cm.m[k][1] * b + cm.m[k][2] * c + cm.bias[k]) >> COLOR_SHIFT;
+        return static_cast<u8>(std::clamp(v, 0, 255));
+    }
+
+    inline void colorMatrixPixels(u8* px, std::size_t n, const ColorMatrix& cm, const ChannelOrder& order) {
+        std::size_t i = 0;
+#if LIB_IMG_SSE2
+        // 8 pixels at a time: gathered into 16-bit planes, two pmaddwd per output lane pair, saturated back.
+        const __m128i zero = _mm_setzero_si128();
+        __m128i       pairs[3][2];
+        __m128i       bias[3];
+        for (u32 k = 0; k < 3; ++k) {
+            pairs[k][0] = _mm_set1_epi32(static_cast<u16>(cm.m[k][0]) | (static_cast<u32>(cm.m[k][1]) << 16));
+            pairs[k][1] = _mm_set1_epi32(static_cast<u16>(cm.m[k][2]));
+            bias[k]     = _mm_set1_epi32(cm.bias[k]);
+        }
+
+        for (; i + 8 <= n; i += 8) {
+            alignas(16) i16 planes[3][8];
+            alignas(16) u8  out[3][16];
+            u8*             p = px + i * 3;
+            for (u32 j = 0; j < 8; ++j) {
+                planes[0][j] = p[j * 3 + order[0]];
+                planes[1][j] = p[j * 3 + order[1]];
+                planes[2][j] = p[j * 3 + order[2]];
+            }
+
+            const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[0]));
+            const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[1]));
+            const __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[2]));
+            for (u32 k = 0; k < 3; ++k) {
+                const __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), pairs[k][0]),
+                                                               _mm_madd_epi16(_mm_unpacklo_epi16(c, zero), pairs[k][1])),
+                                                 bias[k]);
+                const __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), pairs[k][0]),
+                                                               _mm_madd_epi16(_mm_unpackhi_epi16(c, zero), pairs[k][1])),
+                                                 bias[k]);
+                const __m128i v  = _mm_packs_epi32(_mm_srai_epi32(lo, COLOR_SHIFT), _mm_srai_epi32(hi, COLOR_SHIFT));
+                _mm_store_si128(reinterpret_cast<__m128i*>(out[k]), _mm_packus_epi16(v, v));
+            }
+
+            for (u32 j = 0; j < 8; ++j) {
+                p[j * 3 + order[0]] = out[0][j];
+                p[j * 3 + order[1]] = out[1][j];
+                p[j * 3 + order[2]] = out[2][j];
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            u8*       p = px + i * 3;
+            const i32 a = p[order[0]], b = p[order[1]], c = p[order[2]];
+            p[order[0]] = applyColorMatrix(cm, 0, a, b, c);
+            p[order[1]] = applyColorMatrix(cm, 1, a, b, c);
+            p[order[2]] = applyColorMatrix(cm, 2, a, b, c);
+        }
+    }
+
+    // hue of (r, g, b) in 256 steps per turn, given max and max - min.
+    inline u8 hue8(float r, float g, float b, float max, float delta) {
+        if (delta <= 0.0f) {
+            return 0;
+        }
+
+        float sector;
+        if (max == r) {
+            sector = (g - b) / delta;
+        } else if (max == g) {
+            sector = 2.0f + (b - r) / delta;
+        } else {
+            sector = 4.0f + (r - g) / delta;
+        }
+        // shifted positive so truncation rounds, red at the wrap point lands back on 0.
+        return static_cast<u8>(static_cast<i32>(sector * (256.0f / 6.0f) + 256.5f) & 0xFF);
+    }
+
+    // (r, g, b) in [0, 1] from hue steps and chroma, `m` added to every channel.
+    inline void hueToRgb(u8 hue, float chroma, float m, float& r, float& g, float& b) {
+        const float h = hue * (6.0f / 256.0f);
+        const float x = chroma * (1.0f - std::abs(std::fmod(h, 2.0f) - 1.0f));
+
+        // clang-format off
+        switch (static_cast<u32>(h)) {
+            case 0:  r = chroma; g = x;      b = 0;      break;
+            case 1:  r = x;      g = chroma; b = 0;      break;
+            case 2:  r = 0;      g = chroma; b = x;      break;
+            case 3:  r = 0;      g = x;      b = chroma; break;
+            case 4:  r = x;      g = 0;      b = chroma; break;
+            default: r = chroma; g = 0;      b = x;      break;
+        }
+        // clang-format on
+        r += m;
+        g += m;
+        b += m;
+    }
+
+    inline u8 roundToU8(float v) {
+        return static_cast<u8>(std::clamp(v, 0.0f, 255.0f) + 0.5f);
+    }
+
+    inline u8 unitToU8(float v) {
+        return roundToU8(v * 255.0f);
+    }
+
+    // an 8-bit round trip through HSV is off by at most 3 steps, through HSL by at most 4: hue has 256 steps for
+    // 1530 distinct rgb hues and saturation loses precision as chroma shrinks.
+    inline void rgbToHsvPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*       p     = px + i * 3;
+            const u8  r     = p[order[0]], g = p[order[1]], b = p[order[2]];
+            const u8  max   = std::max({r, g, b});
+            const u8  delta = static_cast<u8>(max - std::min({r, g, b}));
+            p[order[0]]     = hue8(r, g, b, max, delta);
+            p[order[1]]     = max == 0 ? 0 : static_cast<u8>((delta * 255 + max / 2) / max);
+            p[order[2]]     = max;
+        }
+    }
+
+    inline void hsvToRgbPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*         p      = px + i * 3;
+            const float v      = p[order[2]] / 255.0f;
+            const float chroma = v * (p[order[1]] / 255.0f);
+
+            float r, g, b;
+            hueToRgb(p[order[0]], chroma, v - chroma, r, g, b);
+            p[order[0]] = unitToU8(r);
+            p[order[1]] = unitToU8(g);
+            p[order[2]] = unitToU8(b);
+        }
+    }
+
+    inline void rgbToHslPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*       p     = px + i * 3;
+            const u8  r     = p[order[0]], g = p[order[1]], b = p[order[2]];
+            const u32 max   = std::max({r, g, b});
+            const u32 min   = std::min({r, g, b});
+            const u32 delta = max - min;
+            const u32 sum   = max + min;
+            // saturation is chroma over the largest chroma this lightness allows.
+            const u32 limit = sum <= 255 ? sum : 510 - sum;
+
+            p[order[0]] = hue8(r, g, b, static_cast<float>(max), static_cast<float>(delta));
+            p[order[1]] = limit == 0 ? 0 : static_cast<u8>((delta * 255 + limit / 2) / limit);
+            p[order[2]] = static_cast<u8>((sum + 1) / 2);
+        }
+    }
+
+    inline void hslToRgbPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*         p      = px + i * 3;
+            const float l      = p[order[2]] / 255.0f;
+            const float chroma = (1.0f - std::abs(2.0f * l - 1.0f)) * (p[order[1]] / 255.0f);
+
+            float r, g, b;
+            hueToRgb(p[order[0]], chroma, l - chroma / 2.0f, r, g, b);
+            p[order[0]] = unitToU8(r);
+            p[order[1]] = unitToU8(g);
+            p[order[2]] = unitToU8(b);
+        }
+    }
+
+    // sRGB decoding is exact through a 256 entry table, encoding goes through a 4096 entry table over linear
+    // light, which keeps an sRGB -> linear -> sRGB round trip within one step.
+    constexpr u32 LAB_ENCODE_STEPS = 4096;
+
+    inline const std::array<float, 256>& srgbToLinearTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> t{};
+            for (u32 i = 0; i < 256; ++i) {
+                const double c = i / 255.0;
+                t[i]           = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    inline const std::array<u8, LAB_ENCODE_STEPS + 1>& linearToSrgbTable() {
+        static const std::array<u8, LAB_ENCODE_STEPS + 1> table = [] {
+            std::array<u8, LAB_ENCODE_STEPS + 1> t{};
+            for (u32 i = 0; i <= LAB_ENCODE_STEPS; ++i) {
+                const double c = static_cast<double>(i) / LAB_ENCODE_STEPS;
+                const double s = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+                t[i]           = static_cast<u8>(std::lround(std::clamp(s, 0.0, 1.0) * 255.0));
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    inline u8 linearToSrgb(float c) {
+        const float index = std::clamp(c, 0.0f, 1.0f) * LAB_ENCODE_STEPS;
+        return linearToSrgbTable()[static_cast<u32>(index + 0.5f)];
+    }
+
+    // cube root of a normal positive float: the exponent is split off the bits, a quadratic fit of the mantissa's
+    // root on [0.5, 1) is refined by one Newton step and scaled by the root of the exponent's remainder.
+    inline float cbrtFast(float x) {
+        constexpr float ROOT_2[3] = {1.0f, 1.25992105f, 1.58740105f};
+
+        const u32   bits = std::bit_cast<u32>(x);
+        const i32   e    = static_cast<i32>((bits >> 23) & 0xFF) - 126;
+        const float m    = std::bit_cast<float>((bits & 0x807FFFFFu) | (126u << 23));
+        float       y    = 0.4761393f + m * (0.7258546f - m * 0.2013523f);
+        y                = (2.0f * y + m / (y * y)) * (1.0f / 3.0f);
+
+        const i32 q = (e >= 0 ? e : e - 2) / 3;
+        return y * ROOT_2[e - 3 * q] * std::bit_cast<float>(static_cast<u32>(q + 127) << 23);
+    }
+
+    // CIE Lab against the D65 white point.
+    constexpr float LAB_EPSILON = 216.0f / 24389.0f;
+    constexpr float LAB_KAPPA   = 24389.0f / 27.0f;
+    constexpr float LAB_WHITE_X = 0.95047f;
+    constexpr float LAB_WHITE_Z = 1.08883f;
+
+    inline float labF(float t) {
+        return t > LAB_EPSILON ? cbrtFast(t) : (LAB_KAPPA * t + 16.0f) / 116.0f;
+    }
+
+    inline float labFInverse(float f) {
+        const float f3 = f * f * f;
+        return f3 > LAB_EPSILON ? f3 : (116.0f * f - 16.0f) / LAB_KAPPA;
+    }
+
+    // the 8-bit Lab encoding is lossy: L steps by 0.39 and a, b by 1, and around saturated greens and cyans one
+    // Lab step spans several sRGB steps. a round trip is off by up to 26 steps there, e.g. at (26, 246, 248), 93%
+    // of the cube stays within 3.
+    inline void rgbToLabPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        const std::array<float, 256>& lin = srgbToLinearTable();
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*         p = px + i * 3;
+            const float r = lin[p[order[0]]], g = lin[p[order[1]]], b = lin[p[order[2]]];
+
+            const float fx = labF((0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / LAB_WHITE_X);
+            const float fy = labF(0.2126729f * r + 0.7151522f * g + 0.0721750f * b);
+            const float fz = labF((0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / LAB_WHITE_Z);
+
+            p[order[0]] = unitToU8((116.0f * fy - 16.0f) / 100.0f);
+            p[order[1]] = roundToU8(500.0f * (fx - fy) + 128.0f);
+            p[order[2]] = roundToU8(200.0f * (fy - fz) + 128.0f);
+        }
+    }
+
+    inline void labToRgbPixels(u8* px, std::size_t n, const ChannelOrder& order) {
+        for (std::size_t i = 0; i < n; ++i) {
+            u8*         p  = px + i * 3;
+            const float fy = (p[order[0]] * (100.0f / 255.0f) + 16.0f) / 116.0f;
+            const float fx = fy + (p[order[1]] - 128) / 500.0f;
+            const float fz = fy - (p[order[2]] - 128) / 200.0f;
+
+            const float x = labFInverse(fx) * LAB_WHITE_X;
+            const float y = labFInverse(fy);
+            const float z = labFInverse(fz) * LAB_WHITE_Z;
+
+            p[order[0]] = linearToSrgb(3.2404542f * x - 1.5371385f * y - 0.4985314f * z);
+            p[order[1]] = linearToSrgb(-0.9692660f * x + 1.8760108f * y + 0.0415560f * z);
+            p[order[2]] = linearToSrgb(0.0556434f * x - 0.2040259f * y + 1.0572252f * z);
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_COLOR_H
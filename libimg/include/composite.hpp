@@ -0,0 +1,262 @@
+#ifndef LIB_IMG_COMPOSITE_H
+#define LIB_IMG_COMPOSITE_H
+
+#include <algorithm>
+#include <array>
+
+#include "common.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // separable blend modes, all composite the source over the destination (W3C compositing level 1 formulas).
+    enum BlendMode : u8 {
+        BL_NORMAL   = 0, // porter-duff source-over
+        BL_MULTIPLY = 1,
+        BL_SCREEN   = 2,
+        BL_OVERLAY  = 3,
+        BL_DARKEN   = 4,
+        BL_LIGHTEN  = 5,
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    // the kernels work on premultiplied 4-byte pixels with alpha in the last byte (RGBa8 and BGRa8). each formula
+    // is written as co = f(cs, as, cd, ad), which evaluated on the alpha byte itself gives as + ad - as * ad, so
+    // the alpha lane doesn't need a separate path.
+
+    // round(x / 255) for x in [0, 255 * 255], exact.
+    inline u32 div255(u32 x) {
+        return ((x + 128) * 257) >> 16;
+    }
+
+#if LIB_IMG_SSE2
+    inline __m128i div255(__m128i x) {
+        return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+    }
+
+    // broadcasts each pixel's alpha (lanes 3 and 7) over its four 16-bit lanes.
+    inline __m128i broadcastAlpha(__m128i px) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xFF), 0xFF);
+    }
+
+    // unsigned 16-bit max/min, SSE2 only has the signed ones.
+    inline __m128i maxU16(__m128i a, __m128i b) {
+        const __m128i bias = _mm_set1_epi16(static_cast<i16>(0x8000));
+        return _mm_xor_si128(_mm_max_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)), bias);
+    }
+
+    inline __m128i minU16(__m128i a, __m128i b) {
+        const __m128i bias = _mm_set1_epi16(static_cast<i16>(0x8000));
+        return _mm_xor_si128(_mm_min_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)), bias);
+    }
+#endif
+
+    struct BlendOver {
+        static u32 scalar(u32 cs, u32 as, u32 cd, u32) {
+            return cs + div255(cd * (255 - as));
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i as, __m128i cd, __m128i) {
+            return _mm_add_epi16(cs, div255(_mm_mullo_epi16(cd, _mm_sub_epi16(_mm_set1_epi16(255), as))));
+        }
+#endif
+    };
+
+    // cs * (1 - ad) + cd * (1 - as) + cs * cd
+    struct BlendMultiply {
+        static u32 scalar(u32 cs, u32 as, u32 cd, u32 ad) {
+            return div255(cs * (255 - ad) + cd * (255 - as) + cs * cd);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i as, __m128i cd, __m128i ad) {
+            const __m128i full  = _mm_set1_epi16(255);
+            const __m128i keepS = _mm_mullo_epi16(cs, _mm_sub_epi16(full, ad));
+            const __m128i keepD = _mm_mullo_epi16(cd, _mm_sub_epi16(full, as));
+            return div255(_mm_add_epi16(_mm_add_epi16(keepS, keepD), _mm_mullo_epi16(cs, cd)));
+        }
+#endif
+    };
+
+    // cs + cd - cs * cd
+    struct BlendScreen {
+        static u32 scalar(u32 cs, u32, u32 cd, u32) {
+            return cs + cd - div255(cs * cd);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i, __m128i cd, __m128i) {
+            return _mm_sub_epi16(_mm_add_epi16(cs, cd), div255(_mm_mullo_epi16(cs, cd)));
+        }
+#endif
+    };
+
+    // hard light with the layers swapped: multiply where the destination is dark, screen where it's light.
+    struct BlendOverlay {
+        static u32 scalar(u32 cs, u32 as, u32 cd, u32 ad) {
+            const u32 mixed = 2 * cd <= ad ? 2 * cs * cd : as * ad - 2 * (ad - cd) * (as - cs);
+            return div255(cs * (255 - ad) + cd * (255 - as) + mixed);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i as, __m128i cd, __m128i ad) {
+            const __m128i full     = _mm_set1_epi16(255);
+            const __m128i keepS    = _mm_mullo_epi16(cs, _mm_sub_epi16(full, ad));
+            const __m128i keepD    = _mm_mullo_epi16(cd, _mm_sub_epi16(full, as));
+            const __m128i dark     = _mm_cmpgt_epi16(_mm_add_epi16(ad, _mm_set1_epi16(1)), _mm_add_epi16(cd, cd));
+            const __m128i multiply = _mm_slli_epi16(_mm_mullo_epi16(cs, cd), 1);
+            const __m128i inverse  = _mm_mullo_epi16(_mm_sub_epi16(ad, cd), _mm_sub_epi16(as, cs));
+            const __m128i screen   = _mm_sub_epi16(_mm_mullo_epi16(as, ad), _mm_slli_epi16(inverse, 1));
+            const __m128i mixed    = _mm_or_si128(_mm_and_si128(dark, multiply), _mm_andnot_si128(dark, screen));
+            return div255(_mm_add_epi16(_mm_add_epi16(keepS, keepD), mixed));
+        }
+#endif
+    };
+
+    // cs + cd - max(cs * ad, cd * as)
+    struct BlendDarken {
+        static u32 scalar(u32 cs, u32 as, u32 cd, u32 ad) {
+            return cs + cd - div255(std::max(cs * ad, cd * as));
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i as, __m128i cd, __m128i ad) {
+            const __m128i picked = maxU16(_mm_mullo_epi16(cs, ad), _mm_mullo_epi16(cd, as));
+            return _mm_sub_epi16(_mm_add_epi16(cs, cd), div255(picked));
+        }
+#endif
+    };
+
+    // cs + cd - min(cs * ad, cd * as)
+    struct BlendLighten {
+        static u32 scalar(u32 cs, u32 as, u32 cd, u32 ad) {
+            return cs + cd - div255(std::min(cs * ad, cd * as));
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i cs, __m128i as, __m128i cd, __m128i ad) {
+            const __m128i picked = minU16(_mm_mullo_epi16(cs, ad), _mm_mullo_epi16(cd, as));
+            return _mm_sub_epi16(_mm_add_epi16(cs, cd), div255(picked));
+        }
+#endif
+    };
+
+    // dst = blend(src over dst) for `n` premultiplied 4-byte pixels.
+    template<typename Op>
+    void blendRow(u8* dst, const u8* src, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4) {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+
+            const __m128i sLo = _mm_unpacklo_epi8(s, zero), sHi = _mm_unpackhi_epi8(s, zero);
+            const __m128i dLo = _mm_unpacklo_epi8(d, zero), dHi = _mm_unpackhi_epi8(d, zero);
+
+            const __m128i lo = Op::sse(sLo, broadcastAlpha(sLo), dLo, broadcastAlpha(dLo));
+            const __m128i hi = Op::sse(sHi, broadcastAlpha(sHi), dHi, broadcastAlpha(dHi));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; i < n; ++i) {
+            const u8* s = src + i * 4;
+            u8*       d = dst + i * 4;
+            const u32 as = s[3], ad = d[3];
+            for (u32 c = 0; c < 4; ++c) {
+                d[c] = static_cast<u8>(std::min<u32>(255, Op::scalar(s[c], as, d[c], ad)));
+            }
+        }
+    }
+
+    inline void blendRow(u8* dst, const u8* src, std::size_t n, BlendMode mode) {
+        switch (mode) {
+            case BL_NORMAL: blendRow<BlendOver>(dst, src, n); break;
+            case BL_MULTIPLY: blendRow<BlendMultiply>(dst, src, n); break;
+            case BL_SCREEN: blendRow<BlendScreen>(dst, src, n); break;
+            case BL_OVERLAY: blendRow<BlendOverlay>(dst, src, n); break;
+            case BL_DARKEN: blendRow<BlendDarken>(dst, src, n); break;
+            case BL_LIGHTEN: blendRow<BlendLighten>(dst, src, n); break;
+        }
+    }
+
+    // colour bytes *= alpha / 255, alpha is kept.
+    inline void premultiplyRow(u8* px, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_SSE2
+        const __m128i zero       = _mm_setzero_si128();
+        const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i full       = _mm_and_si128(alphaLanes, _mm_set1_epi16(255));
+        auto          scale      = [&](__m128i v) {
+            const __m128i factor = _mm_or_si128(_mm_andnot_si128(alphaLanes, broadcastAlpha(v)), full);
+            return div255(_mm_mullo_epi16(v, factor));
+        };
+        for (; i + 4 <= n; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i * 4));
+            const __m128i r = _mm_packus_epi16(scale(_mm_unpacklo_epi8(v, zero)), scale(_mm_unpackhi_epi8(v, zero)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i * 4), r);
+        }
+#endif
+        for (; i < n; ++i) {
+            u8* p = px + i * 4;
+            for (u32 c = 0; c < 3; ++c) {
+                p[c] = static_cast<u8>(div255(u32{p[c]} * p[3]));
+            }
+        }
+    }
+
+    // colour bytes *= 255 / alpha through a Q16 reciprocal table, fully transparent pixels become 0.
+    inline void unpremultiplyRow(u8* px, std::size_t n) {
+        static const std::array<u32, 256> RECIPROCAL = [] {
+            std::array<u32, 256> t{};
+            for (u32 a = 1; a < 256; ++a) {
+                t[a] = ((255u << 16) + a / 2) / a;
+            }
+            return t;
+        }();
+
+        std::size_t i = 0;
+#if LIB_IMG_SSE2
+        // the reciprocal split into its integer part and Q16 fraction, c * r = c * int + (c * frac) >> 16 keeps
+        // both products in 16-bit lanes. spread over a pixel's four lanes, the alpha lane is scaled by 1.
+        static const std::array<std::array<u64, 2>, 256> LANES = [] {
+            std::array<std::array<u64, 2>, 256> t{};
+            for (u32 a = 0; a < 256; ++a) {
+                const u64 frac = RECIPROCAL[a] & 0xFFFF, whole = RECIPROCAL[a] >> 16;
+                t[a]           = {frac | frac << 16 | frac << 32, whole | whole << 16 | whole << 32 | u64{1} << 48};
+            }
+            return t;
+        }();
+
+        const __m128i zero  = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi16(255);
+        // two pixels widened to 16 bits, `a0` and `a1` are their alphas.
+        auto scale = [&](__m128i v, u8 a0, u8 a1) {
+            const __m128i frac  = _mm_set_epi64x(static_cast<i64>(LANES[a1][0]), static_cast<i64>(LANES[a0][0]));
+            const __m128i whole = _mm_set_epi64x(static_cast<i64>(LANES[a1][1]), static_cast<i64>(LANES[a0][1]));
+
+            // (c * frac + 2^15) >> 16 is the high half plus the rounding carry out of the low half.
+            const __m128i lowCarry = _mm_srli_epi16(_mm_mullo_epi16(v, frac), 15);
+            const __m128i fracPart = _mm_add_epi16(_mm_mulhi_epu16(v, frac), lowCarry);
+            const __m128i r        = _mm_add_epi16(_mm_mullo_epi16(v, whole), fracPart);
+            return _mm_sub_epi16(r, _mm_subs_epu16(r, limit)); // min(r, 255), unsigned
+        };
+        for (; i + 4 <= n; i += 4) {
+            u8*           p = px + i * 4;
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i r = _mm_packus_epi16(scale(_mm_unpacklo_epi8(v, zero), p[3], p[7]),
+                                               scale(_mm_unpackhi_epi8(v, zero), p[11], p[15]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r);
+        }
+#endif
+        for (; i < n; ++i) {
+            u8*       p = px + i * 4;
+            const u32 r = RECIPROCAL[p[3]];
+            for (u32 c = 0; c < 3; ++c) {
+                p[c] = static_cast<u8>(std::min<u32>(255, (p[c] * r + (1u << 15)) >> 16));
+            }
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_COMPOSITE_H
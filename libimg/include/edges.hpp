@@ -0,0 +1,320 @@
+#ifndef LIB_IMG_EDGES_H
+#define LIB_IMG_EDGES_H
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numbers>
+#include <vector>
+
+#include "border.hpp"
+#include "common.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // 3x3 derivative kernels, both are a central difference smoothed across by (side, centre, side).
+    enum GradientKernel : u8 {
+        GK_SOBEL  = 0, // 1 2 1
+        GK_SCHARR = 1, // 3 10 3
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    struct GradientWeights {
+        i16 side;
+        i16 centre;
+        u32 shift; // log2 of the smoothing weights' sum, brings a full 0 -> 255 step back to 255
+    };
+
+    constexpr GradientWeights gradientWeights(GradientKernel kernel) {
+        return kernel == GK_SCHARR ? GradientWeights{3, 10, 4} : GradientWeights{1, 2, 2};
+    }
+
+    // gx/gy of row `mid` from its neighbours `above`/`below`, the rows are read in place and only the first and last
+    // column replicate the edge.
+    inline void
+    gradientRow(const u8* above, const u8* mid, const u8* below, u32 width, GradientWeights w, i16* gx, i16* gy) {
+        if (width == 0) {
+            return;
+        }
+
+        auto scalar = [&](u32 x) {
+            const u32 l  = x > 0 ? x - 1 : 0;
+            const u32 r  = std::min(x + 1, width - 1);
+            const i32 dx = w.side * (above[r] - above[l] + below[r] - below[l]) + w.centre * (mid[r] - mid[l]);
+            const i32 dy = w.side * (below[l] - above[l] + below[r] - above[r]) + w.centre * (below[x] - above[x]);
+            gx[x]        = static_cast<i16>(dx);
+            gy[x]        = static_cast<i16>(dy);
+        };
+
+        const auto [begin, end] = BorderedView::interior(width, 1, 1);
+        for (u32 x = 0; x < begin; ++x) {
+            scalar(x);
+        }
+
+        u32 x = begin;
+#if LIB_IMG_AVX2
+        {
+            auto load = [](const u8* p) {
+                return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            };
+            const __m256i side   = _mm256_set1_epi16(w.side);
+            const __m256i centre = _mm256_set1_epi16(w.centre);
+            for (; x + 16 <= end; x += 16) {
+                const __m256i al = load(above + x - 1), ac = load(above + x), ar = load(above + x + 1);
+                const __m256i ml = load(mid + x - 1), mr = load(mid + x + 1);
+                const __m256i bl = load(below + x - 1), bc = load(below + x), br = load(below + x + 1);
+
+                const __m256i hx = _mm256_add_epi16(_mm256_sub_epi16(ar, al), _mm256_sub_epi16(br, bl));
+                const __m256i hy = _mm256_add_epi16(_mm256_sub_epi16(bl, al), _mm256_sub_epi16(br, ar));
+                const __m256i dx = _mm256_add_epi16(_mm256_mullo_epi16(side, hx),
+                                                    _mm256_mullo_epi16(centre, _mm256_sub_epi16(mr, ml)));
+                const __m256i dy = _mm256_add_epi16(_mm256_mullo_epi16(side, hy),
+                                                    _mm256_mullo_epi16(centre, _mm256_sub_epi16(bc, ac)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(gx + x), dx);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(gy + x), dy);
+            }
+        }
+#endif
+#if LIB_IMG_SSE2
+        {
+            const __m128i zero = _mm_setzero_si128();
+            auto          load = [zero](const u8* p) {
+                return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+            };
+            const __m128i side   = _mm_set1_epi16(w.side);
+            const __m128i centre = _mm_set1_epi16(w.centre);
+            for (; x + 8 <= end; x += 8) {
+                const __m128i al = load(above + x - 1), ac = load(above + x), ar = load(above + x + 1);
+                const __m128i ml = load(mid + x - 1), mr = load(mid + x + 1);
+                const __m128i bl = load(below + x - 1), bc = load(below + x), br = load(below + x + 1);
+
+                const __m128i hx = _mm_add_epi16(_mm_sub_epi16(ar, al), _mm_sub_epi16(br, bl));
+                const __m128i hy = _mm_add_epi16(_mm_sub_epi16(bl, al), _mm_sub_epi16(br, ar));
+                const __m128i dx
+                    = _mm_add_epi16(_mm_mullo_epi16(side, hx), _mm_mullo_epi16(centre, _mm_sub_epi16(mr, ml)));
+                const __m128i dy
+                    = _mm_add_epi16(_mm_mullo_epi16(side, hy), _mm_mullo_epi16(centre, _mm_sub_epi16(bc, ac)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(gx + x), dx);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(gy + x), dy);
+            }
+        }
+#endif
+        for (; x < end; ++x) {
+            scalar(x);
+        }
+        for (x = end; x < width; ++x) {
+            scalar(x);
+        }
+    }
+
+    // mag[i] = |gx[i]| + |gy[i]|, cheaper than the euclidean norm and what the canny thresholds are compared to.
+    inline void l1Magnitude(const i16* gx, const i16* gy, u16* mag, u32 n) {
+        u32 i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 16 <= n; i += 16) {
+            const __m256i a = _mm256_abs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gx + i)));
+            const __m256i b = _mm256_abs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gy + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(mag + i), _mm256_add_epi16(a, b));
+        }
+#endif
+#if LIB_IMG_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gx + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gy + i));
+            const __m128i s = _mm_add_epi16(_mm_max_epi16(a, _mm_sub_epi16(zero, a)),
+                                            _mm_max_epi16(b, _mm_sub_epi16(zero, b)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(mag + i), s);
+        }
+#endif
+        for (; i < n; ++i) {
+            mag[i] = static_cast<u16>(std::abs(gx[i]) + std::abs(gy[i]));
+        }
+    }
+
+    // out[i] = min(255, mag[i] >> shift).
+    inline void narrowMagnitude(const u16* mag, u32 shift, u8* out, u32 n) {
+        u32 i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 32 <= n; i += 32) {
+            const __m256i a = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(mag + i)), shift);
+            const __m256i b
+                = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(mag + i + 16)), shift);
+            // packus interleaves the 128-bit lanes, put them back in order.
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+#endif
+#if LIB_IMG_SSE2
+        const __m128i count = _mm_cvtsi32_si128(static_cast<int>(shift));
+        for (; i + 16 <= n; i += 16) {
+            const __m128i a = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mag + i)), count);
+            const __m128i b = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mag + i + 8)), count);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+        }
+#endif
+        for (; i < n; ++i) {
+            out[i] = static_cast<u8>(std::min<u32>(255, mag[i] >> shift));
+        }
+    }
+
+    // gradient angle atan2(gy, gx) with 256 steps per turn, 0 points along +x and 64 along +y (down).
+    inline void directionRow(const i16* gx, const i16* gy, u8* out, u32 n) {
+        constexpr float STEPS_PER_RADIAN = 128.0f / std::numbers::pi_v<float>;
+        for (u32 i = 0; i < n; ++i) {
+            const float steps = std::atan2(static_cast<float>(gy[i]), static_cast<float>(gx[i])) * STEPS_PER_RADIAN;
+            out[i]          = static_cast<u8>(static_cast<i32>(std::lround(steps)) & 0xFF);
+        }
+    }
+
+    // per-pixel magnitude (and direction) of a single channel image, borders replicate the edge pixels.
+    inline void gradient(const u8* src, u8* mag, u8* direction, u32 width, u32 height, GradientKernel kernel) {
+        const GradientWeights w = gradientWeights(kernel);
+
+        parallelFor(0, height, 32, [&](u32 y0, u32 y1) {
+            std::vector<i16> gx(width), gy(width);
+            std::vector<u16> l1(width);
+
+            for (u32 y = y0; y < y1; ++y) {
+                const u8* above = src + std::size_t{y > 0 ? y - 1 : 0} * width;
+                const u8* below = src + std::size_t{std::min(y + 1, height - 1)} * width;
+                gradientRow(above, src + std::size_t{y} * width, below, width, w, gx.data(), gy.data());
+
+                l1Magnitude(gx.data(), gy.data(), l1.data(), width);
+                narrowMagnitude(l1.data(), w.shift, mag + std::size_t{y} * width, width);
+                if (direction) {
+                    directionRow(gx.data(), gy.data(), direction + std::size_t{y} * width, width);
+                }
+            }
+        });
+    }
+
+    enum CannyMark : u8 {
+        CM_NONE   = 0,
+        CM_WEAK   = 1,
+        CM_STRONG = 2,
+    };
+
+    // canny on the 3x3 sobel response without pre-smoothing: gradients and non-maximum suppression are fused
+    // per row band, keeping three rows of magnitudes alive, then strong edges grow into connected weak ones.
+    // thresholds compare against |gx| + |gy| (0 .. 2040).
+    inline void canny(const u8* src, u8* dst, u32 width, u32 height, u16 lowThreshold, u16 highThreshold) {
+        const GradientWeights w = gradientWeights(GK_SOBEL);
+
+        // tan(22.5deg) in Q15, tan(67.5deg) is exactly 2 more, so the gradient's octant is picked without a division.
+        constexpr i32 TAN_22_5_Q15 = 13573;
+
+        // one pixel of CM_NONE around the marks, so neither pass needs bounds checks.
+        const std::size_t stride = std::size_t{width} + 2;
+        std::vector<u8>   marks(stride * (std::size_t{height} + 2), CM_NONE);
+
+        std::mutex       seedsMutex;
+        std::vector<u8*> seeds;
+
+        parallelFor(0, height, 64, [&](u32 y0, u32 y1) {
+            // ring of three rows, magnitudes padded by a zero column on each side.
+            std::vector<i16> gx(3 * std::size_t{width}), gy(3 * std::size_t{width});
+            std::vector<u16> mag(3 * stride, 0);
+            std::vector<u8*> localSeeds;
+
+            auto slot = [](i64 y) { return static_cast<std::size_t>((y + 1) % 3); };
+
+            auto computeRow = [&](i64 y) {
+                u16* m = &mag[slot(y) * stride];
+                if (y < 0 || y >= i64{height}) {
+                    std::fill_n(m, stride, 0);
+                    return;
+                }
+
+                const u32 row   = static_cast<u32>(y);
+                const u8* above = src + std::size_t{row > 0 ? row - 1 : 0} * width;
+                const u8* below = src + std::size_t{std::min(row + 1, height - 1)} * width;
+                i16*      x     = &gx[slot(y) * width];
+                i16*      yy    = &gy[slot(y) * width];
+                gradientRow(above, src + std::size_t{row} * width, below, width, w, x, yy);
+                l1Magnitude(x, yy, m + 1, width);
+            };
+
+            computeRow(i64{y0} - 1);
+            computeRow(y0);
+            for (u32 y = y0; y < y1; ++y) {
+                computeRow(i64{y} + 1);
+
+                const u16* prev = &mag[slot(i64{y} - 1) * stride] + 1;
+                const u16* cur  = &mag[slot(y) * stride] + 1;
+                const u16* next = &mag[slot(i64{y} + 1) * stride] + 1;
+                const i16* dx   = &gx[slot(y) * width];
+                const i16* dy   = &gy[slot(y) * width];
+                u8*        out  = &marks[(std::size_t{y} + 1) * stride + 1];
+
+                for (u32 x = 0; x < width; ++x) {
+                    const i32 m = cur[x];
+                    if (m <= lowThreshold) {
+                        continue;
+                    }
+
+                    const i32 ax    = std::abs(dx[x]);
+                    const i32 ay    = std::abs(dy[x]) << 15;
+                    const i32 tan22 = ax * TAN_22_5_Q15;
+                    const i32 tan67 = tan22 + (ax << 16);
+
+                    bool isMax;
+                    if (ay < tan22) {
+                        isMax = m > cur[i64{x} - 1] && m >= cur[x + 1];
+                    } else if (ay > tan67) {
+                        isMax = m > prev[x] && m >= next[x];
+                    } else {
+                        // same signs: the gradient points down-right, so the neighbours are on that diagonal.
+                        const i32 s = (dx[x] ^ dy[x]) < 0 ? -1 : 1;
+                        isMax       = m > prev[i64{x} - s] && m > next[i64{x} + s];
+                    }
+
+                    if (isMax) {
+                        if (m > highThreshold) {
+                            out[x] = CM_STRONG;
+                            localSeeds.push_back(out + x);
+                        } else {
+                            out[x] = CM_WEAK;
+                        }
+                    }
+                }
+            }
+
+            std::lock_guard lock{seedsMutex};
+            seeds.insert(seeds.end(), localSeeds.begin(), localSeeds.end());
+        });
+
+        // hysteresis: depth-first growth from every strong pixel through 8-connected weak ones.
+        const std::ptrdiff_t s          = static_cast<std::ptrdiff_t>(stride);
+        const std::ptrdiff_t offsets[8] = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+        while (!seeds.empty()) {
+            u8* p = seeds.back();
+            seeds.pop_back();
+            for (const std::ptrdiff_t o : offsets) {
+                if (p[o] == CM_WEAK) {
+                    p[o] = CM_STRONG;
+                    seeds.push_back(p + o);
+                }
+            }
+        }
+
+        parallelFor(0, height, 64, [&](u32 y0, u32 y1) {
+            for (u32 y = y0; y < y1; ++y) {
+                const u8* in  = &marks[(std::size_t{y} + 1) * stride + 1];
+                u8*       out = dst + std::size_t{y} * width;
+                for (u32 x = 0; x < width; ++x) {
+                    out[x] = static_cast<u8>(0 - (in[x] >> 1)); // CM_STRONG -> 255, anything else -> 0
+                }
+            }
+        });
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_EDGES_H
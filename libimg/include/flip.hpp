@@ -0,0 +1,155 @@
+#ifndef LIB_IMG_FLIP_H
+#define LIB_IMG_FLIP_H
+
+#include <algorithm>
+#include <cstring>
+
+#include "common.hpp"
+#include "img_assert.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img::detail {
+
+    // rows are exchanged through a stack buffer in blocks of this many bytes, three memcpys per block.
+    constexpr std::size_t FLIP_BLOCK = 4096;
+
+    inline void swapRows(u8* a, u8* b, std::size_t n) {
+        u8 tmp[FLIP_BLOCK];
+        for (std::size_t i = 0; i < n; i += FLIP_BLOCK) {
+            const std::size_t len = std::min(FLIP_BLOCK, n - i);
+            std::memcpy(tmp, a + i, len);
+            std::memcpy(a + i, b + i, len);
+            std::memcpy(b + i, tmp, len);
+        }
+    }
+
+    inline void flipRows(u8* data, u32 height, std::size_t rowBytes) {
+        parallelFor(0, height / 2, 16, [&](u32 y0, u32 y1) {
+            for (u32 y = y0; y < y1; ++y) {
+                swapRows(data + y * rowBytes, data + (height - 1 - y) * rowBytes, rowBytes);
+            }
+        });
+    }
+
+#if LIB_IMG_SSE2
+    // reverses the order of the `C` byte pixels in a 16 byte vector, `C` dividing 16.
+    template<u32 C>
+    __m128i reversePixels(__m128i v) {
+        if constexpr (C == 1) {
+    #if LIB_IMG_SSSE3
+            return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    #else
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            return reversePixels<2>(v);
+    #endif
+        } else if constexpr (C == 2) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+            return _mm_shuffle_epi32(v, 0x4E);
+        } else if constexpr (C == 4) {
+            return _mm_shuffle_epi32(v, 0x1B);
+        } else {
+            return _mm_shuffle_epi32(v, 0x4E);
+        }
+    }
+#endif
+
+#if LIB_IMG_AVX2
+    template<u32 C>
+    __m256i reversePixels(__m256i v) {
+        if constexpr (C == 1) {
+            const __m256i mask = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                  15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            v                  = _mm256_shuffle_epi8(v, mask);
+        } else if constexpr (C == 2) {
+            v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0x1B), 0x1B);
+            v = _mm256_shuffle_epi32(v, 0x4E);
+        } else if constexpr (C == 4) {
+            v = _mm256_shuffle_epi32(v, 0x1B);
+        } else {
+            return _mm256_permute4x64_epi64(v, 0x1B);
+        }
+        return _mm256_permute4x64_epi64(v, 0x4E);
+    }
+#endif
+
+    // mirrors one row of `width` pixels of `C` bytes in place: vectors are taken from both ends, reversed and
+    // stored at the opposite end, whatever is left in the middle is swapped a pixel at a time. 6, 12 and 16 byte
+    // pixels (RGB16 and the float types) only take the pixel swaps.
+    template<u32 C>
+    void flipRow(u8* row, u32 width) {
+        u8* l = row;
+        u8* r = row + std::size_t{width} * C;
+
+        if constexpr (C == 3) {
+#if LIB_IMG_SSSE3
+            // 5 pixels per vector, the 16th byte belongs to the neighbouring pixel and is written back unchanged.
+            // the two blocks keep at least a pixel between them so neither store reaches into the other.
+            const __m128i head  = _mm_setr_epi8(12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, -1);
+            const __m128i tail  = _mm_setr_epi8(-1, 12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2);
+            const __m128i last  = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1);
+            const __m128i first = _mm_setr_epi8(-1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            for (; r - l >= 33; l += 15, r -= 15) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r - 16));
+                // `b` starts one byte early, shifted down its pixels sit where `head` expects them.
+                const __m128i bs      = _mm_srli_si128(b, 1);
+                const __m128i toLeft  = _mm_or_si128(_mm_shuffle_epi8(bs, head), _mm_and_si128(a, last));
+                const __m128i toRight = _mm_or_si128(_mm_shuffle_epi8(a, tail), _mm_and_si128(b, first));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(l), toLeft);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(r - 16), toRight);
+            }
+#endif
+        } else if constexpr (C <= 4 || C == 8) {
+#if LIB_IMG_AVX2
+            for (; r - l >= 64; l += 32, r -= 32) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r - 32));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(l), reversePixels<C>(b));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r - 32), reversePixels<C>(a));
+            }
+#endif
+#if LIB_IMG_SSE2
+            for (; r - l >= 32; l += 16, r -= 16) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r - 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(l), reversePixels<C>(b));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(r - 16), reversePixels<C>(a));
+            }
+#endif
+        }
+
+        for (; r - l >= 2 * static_cast<std::ptrdiff_t>(C); l += C, r -= C) {
+            for (u32 c = 0; c < C; ++c) {
+                std::swap(l[c], (r - C)[c]);
+            }
+        }
+    }
+
+    template<u32 C>
+    void flipColumns(u8* data, u32 width, u32 height) {
+        parallelFor(0, height, 32, [&](u32 y0, u32 y1) {
+            for (u32 y = y0; y < y1; ++y) {
+                flipRow<C>(data + std::size_t{y} * width * C, width);
+            }
+        });
+    }
+
+    inline void flipColumns(u8* data, u32 width, u32 height, std::size_t pixelSize) {
+        switch (pixelSize) {
+            case 1: flipColumns<1>(data, width, height); break;
+            case 2: flipColumns<2>(data, width, height); break;
+            case 3: flipColumns<3>(data, width, height); break;
+            case 4: flipColumns<4>(data, width, height); break;
+            case 6: flipColumns<6>(data, width, height); break;
+            case 8: flipColumns<8>(data, width, height); break;
+            case 12: flipColumns<12>(data, width, height); break;
+            case 16: flipColumns<16>(data, width, height); break;
+            default: IMG_ABORT("unsupported pixel size: %zu", pixelSize);
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_FLIP_H
@@ -0,0 +1,102 @@
+#ifndef LIB_IMG_FORMAT_H
+#define LIB_IMG_FORMAT_H
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <span>
+#include <string_view>
+
+#include "common.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    enum ImageFmt : u16 {
+        IF_UNKOWN = 0X000,
+        IF_JPEG   = 0x001,
+        IF_JPG    = 0x002,
+        IF_PNG    = 0x004,
+        IF_BMP    = 0x008,
+        IF_PSD    = 0x010,
+        IF_TGA    = 0x020,
+        IF_GIF    = 0x040,
+        IF_HDR    = 0x080,
+        IF_PIC    = 0x100,
+        IF_PNM    = 0x200,
+    };
+
+    struct ImageFmtExtension {
+        std::string_view ext;
+        ImageFmt         fmt;
+    };
+
+    // clang-format off
+    constexpr std::array<ImageFmtExtension, 5> IMAGE_FMT_EXTENSIONS{{
+        {".JPEG", IF_JPEG},
+        { ".JPG",  IF_JPG},
+        { ".PNG",  IF_PNG},
+        { ".BMP",  IF_BMP},
+        { ".HDR",  IF_HDR},
+    }};
+    // clang-format on
+
+    // case insensitive lookup of a file extension (dot included), `IF_UNKOWN` if it isn't listed above.
+    constexpr ImageFmt imageFormatFromExtension(std::string_view ext) {
+        auto upper = [](char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c; };
+
+        for (const auto& [name, fmt] : IMAGE_FMT_EXTENSIONS) {
+            if (std::equal(ext.begin(), ext.end(), name.begin(), name.end(), [&upper](char a, char b) {
+                    return upper(a) == b;
+                })) {
+                return fmt;
+            }
+        }
+
+        return IF_UNKOWN;
+    }
+
+    static_assert(imageFormatFromExtension(".jpg") == IF_JPG && imageFormatFromExtension(".Png") == IF_PNG
+                  && imageFormatFromExtension(".tiff") == IF_UNKOWN);
+
+    // bytes `detectImageFormat` needs to see to recognise every signature below.
+    constexpr u32 IMAGE_SIGNATURE_SIZE = 11;
+
+    // sniffs the file signature, TGA has none so it is reported as `IF_UNKOWN` here.
+    constexpr ImageFmt detectImageFormat(std::span<const u8> head) {
+        auto startsWith = [&head](std::initializer_list<u8> sig) {
+            return head.size() >= sig.size() && std::equal(sig.begin(), sig.end(), head.begin());
+        };
+
+        if (startsWith({0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'})) {
+            return IF_PNG;
+        }
+        if (startsWith({0xFF, 0xD8, 0xFF})) {
+            return IF_JPEG;
+        }
+        if (startsWith({'G', 'I', 'F', '8'})) {
+            return IF_GIF;
+        }
+        if (startsWith({'B', 'M'})) {
+            return IF_BMP;
+        }
+        if (startsWith({'8', 'B', 'P', 'S'})) {
+            return IF_PSD;
+        }
+        if (startsWith({'#', '?', 'R', 'A', 'D', 'I', 'A', 'N', 'C', 'E', '\n'})
+            || startsWith({'#', '?', 'R', 'G', 'B', 'E', '\n'})) {
+            return IF_HDR;
+        }
+        if (startsWith({0x53, 0x80, 0xF6, 0x34})) {
+            return IF_PIC;
+        }
+        if (startsWith({'P', '5'}) || startsWith({'P', '6'})) {
+            return IF_PNM;
+        }
+
+        return IF_UNKOWN;
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_FORMAT_H
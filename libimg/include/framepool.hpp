@@ -0,0 +1,185 @@
+#ifndef LIB_IMG_FRAME_POOL_H
+#define LIB_IMG_FRAME_POOL_H
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "image.hpp"
+#include "img_assert.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    struct FramePoolStats {
+        u64 acquires;    // frames handed out
+        u64 allocations; // pixel buffers allocated, flat once the pool holds as many as are ever out at once
+        u64 inUse;       // frames currently handed out
+        u64 idle;        // buffers waiting in the pool
+    };
+
+    // recycles images of one size for streaming work (camera or video frames): `acquire()` hands out a frame that
+    // goes back to the pool when its handle is dropped, so in steady state no frame allocates. frames come back with
+    // whatever they last held. pair it with the operations that write into a destination (`greyScaleLum(dst)`,
+    // `Image::add(a, b, dst)`, copy assignment) to keep temporaries off the heap too. the pool has to outlive its
+    // frames, acquiring and returning are thread safe.
+    template<typename Pixel>
+    class LIB_IMG_PUBLIC FramePool {
+    public:
+        class Frame {
+        public:
+            Frame() = default;
+
+            Frame(const Frame&)            = delete;
+            Frame& operator=(const Frame&) = delete;
+
+            Frame(Frame&& other) noexcept
+                : m_pool(std::exchange(other.m_pool, nullptr)),
+                  m_image(std::move(other.m_image)) {
+            }
+
+            Frame& operator=(Frame&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    m_pool  = std::exchange(other.m_pool, nullptr);
+                    m_image = std::move(other.m_image);
+                }
+                return *this;
+            }
+
+            ~Frame() {
+                release();
+            }
+
+            // returns the frame to its pool early, the handle is empty afterwards.
+            void release() {
+                if (m_pool) {
+                    std::exchange(m_pool, nullptr)->recycle(std::move(m_image));
+                }
+            }
+
+            bool isNull() const {
+                return !m_pool;
+            }
+
+            Image<Pixel>& operator*() {
+                return m_image;
+            }
+
+            const Image<Pixel>& operator*() const {
+                return m_image;
+            }
+
+            Image<Pixel>* operator->() {
+                return &m_image;
+            }
+
+            const Image<Pixel>* operator->() const {
+                return &m_image;
+            }
+
+        private:
+            friend class FramePool;
+
+            Frame(FramePool* pool, Image<Pixel>&& image) : m_pool(pool), m_image(std::move(image)) {
+            }
+
+            FramePool*   m_pool = nullptr;
+            Image<Pixel> m_image;
+        };
+
+        // `preallocate` frames are allocated up front, more are allocated on demand when all of them are out. the ones
+        // the memory budget refuses are left to be allocated on demand.
+        FramePool(u32 width, u32 height, u32 preallocate = 0) : m_width(width), m_height(height) {
+            m_idle.reserve(preallocate);
+            for (u32 i = 0; i < preallocate; ++i) {
+                Image<Pixel> image{width, height};
+                if (!image.isNull()) {
+                    m_idle.push_back(std::move(image));
+                }
+            }
+            m_allocations = m_idle.size();
+        }
+
+        FramePool(const FramePool&)            = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        ~FramePool() {
+            IMG_DEBUG_ASSERT(m_inUse == 0,
+                             "frame pool destroyed with %llu frames still out",
+                             static_cast<unsigned long long>(m_inUse));
+        }
+
+        // a null frame (`Frame::isNull()`) when every frame is out and the memory budget refuses a new one under
+        // MB_FAIL, nothing is counted for it.
+        [[nodiscard]] Frame acquire() {
+            std::unique_lock lock{m_mutex};
+            if (!m_idle.empty()) {
+                ++m_acquires;
+                ++m_inUse;
+                Image<Pixel> image = std::move(m_idle.back());
+                m_idle.pop_back();
+                return Frame{this, std::move(image)};
+            }
+
+            lock.unlock();
+            Image<Pixel> image{m_width, m_height};
+            if (image.isNull()) {
+                return Frame{};
+            }
+
+            lock.lock();
+            ++m_acquires;
+            ++m_inUse;
+            ++m_allocations;
+            m_idle.reserve(m_allocations);
+            return Frame{this, std::move(image)};
+        }
+
+        FramePoolStats stats() const {
+            std::lock_guard lock{m_mutex};
+            return {
+                .acquires    = m_acquires,
+                .allocations = m_allocations,
+                .inUse       = m_inUse,
+                .idle        = m_idle.size(),
+            };
+        }
+
+        u32 width() const {
+            return m_width;
+        }
+
+        u32 height() const {
+            return m_height;
+        }
+
+    private:
+        // a frame's contents are unspecified, so a pending flip or quarter turn is dropped instead of applied and the
+        // buffer fits again as stored. frames an operation resized (pad, crop) no longer fit and are dropped.
+        void recycle(Image<Pixel>&& image) {
+            image.dropOrientation();
+            const bool fits = !image.isNull() && image.width() == m_width && image.height() == m_height;
+
+            std::lock_guard lock{m_mutex};
+            --m_inUse;
+            if (fits) {
+                // reserved for every frame ever allocated, returning one never grows the free list.
+                m_idle.push_back(std::move(image));
+            }
+        }
+
+    private:
+        u32 m_width, m_height;
+
+        mutable std::mutex        m_mutex;
+        std::vector<Image<Pixel>> m_idle;
+        u64                       m_acquires    = 0;
+        u64                       m_allocations = 0;
+        u64                       m_inUse       = 0;
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_FRAME_POOL_H
@@ -0,0 +1,260 @@
+#ifndef LIB_IMG_FRAMES_H
+#define LIB_IMG_FRAMES_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "flip.hpp"
+#include "image.hpp"
+#include "img_assert.hpp"
+#include "lut.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
+#include "pixel.hpp"
+#include "pixel_traits.hpp"
+#include "types.hpp"
+
+#include "stb_image.h"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    // the frames of an animated gif, fully composited (stb applies each frame's disposal), all of them back to back
+    // in the single buffer stb decodes into. frames are handed out as spans into it, operations run one frame per
+    // task across the pool.
+    template<typename Pixel>
+        requires is_color_8_bit_depth<Pixel>
+    class LIB_IMG_PUBLIC FrameSequence {
+    public:
+        using Pixel_t = Pixel;
+
+        FrameSequence() = default;
+
+        FrameSequence(const fs::path& filePath) : FrameSequence() {
+            if (!fs::exists(filePath)) {
+                IMG_ABORT("file does not exist: %s", filePath.c_str());
+            }
+
+            *this = tryLoad(filePath);
+            if (isNull()) {
+                IMG_ABORT("stb couldn't load gif file: %s", filePath.c_str());
+            }
+        }
+
+        FrameSequence(const FrameSequence&)            = delete;
+        FrameSequence& operator=(const FrameSequence&) = delete;
+
+        FrameSequence(FrameSequence&& other) noexcept
+            : m_d(std::exchange(other.m_d, nullptr)),
+              m_width(std::exchange(other.m_width, 0)),
+              m_height(std::exchange(other.m_height, 0)),
+              m_delays(std::move(other.m_delays)) {
+        }
+
+        FrameSequence& operator=(FrameSequence&& other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+
+            freePixels();
+
+            m_d      = std::exchange(other.m_d, nullptr);
+            m_width  = std::exchange(other.m_width, 0);
+            m_height = std::exchange(other.m_height, 0);
+            m_delays = std::move(other.m_delays);
+
+            return *this;
+        }
+
+        ~FrameSequence() {
+            freePixels();
+        }
+
+        // same as `FrameSequence(filePath)` but returns a null sequence instead of aborting when the file can't be
+        // decoded.
+        [[nodiscard]] static FrameSequence tryLoad(const fs::path& filePath) {
+            return tryLoad(detail::readFile(filePath));
+        }
+
+        // decodes an in-memory gif, returns a null sequence on failure or when the memory budget refuses the
+        // frames. the pixels stb hands back are kept as they are, nothing is copied.
+        [[nodiscard]] static FrameSequence tryLoad(std::span<const u8> encoded) {
+            FrameSequence seq;
+            IMG_OP_SCOPE("loadGif", seq);
+            const int c = static_cast<int>(pixel_traits<Pixel_t>::CHANNELS);
+
+            int w, h, fileChannels;
+            if (!stbi_info_from_memory(encoded.data(), static_cast<int>(encoded.size()), &w, &h, &fileChannels)) {
+                return seq;
+            }
+
+            // the frame count is only known once stb decoded them all, the first frame is admitted up front.
+            const u64 frameBytes = u64{static_cast<u32>(w)} * static_cast<u32>(h) * sizeof(Pixel_t);
+            if (!detail::tryChargePixels(frameBytes, 0, true)) {
+                return seq;
+            }
+
+            int  frames;
+            int* delays = nullptr;
+            u8*  d      = stbi_load_gif_from_memory(encoded.data(),
+                                              static_cast<int>(encoded.size()),
+                                              &delays,
+                                              &w,
+                                              &h,
+                                              &frames,
+                                              &fileChannels,
+                                              c);
+
+            detail::releasePixels(frameBytes, 0);
+            if (!d) {
+                return seq;
+            }
+
+            // stb allocated the frames already, they are only accounted for. over the budget they're dropped.
+            const u64 bytes = static_cast<u64>(w) * static_cast<u64>(h) * static_cast<u64>(frames) * sizeof(Pixel_t);
+            if (!detail::tryChargePixels(bytes, 1, true)) {
+                stbi_image_free(d);
+                stbi_image_free(delays);
+                return seq;
+            }
+
+            seq.m_d      = reinterpret_cast<Pixel_t*>(d);
+            seq.m_width  = static_cast<u32>(w);
+            seq.m_height = static_cast<u32>(h);
+            seq.m_delays.resize(static_cast<std::size_t>(frames), 0);
+            if (delays) {
+                std::transform(delays, delays + frames, seq.m_delays.begin(), [](int ms) {
+                    return static_cast<u32>(std::max(ms, 0));
+                });
+                stbi_image_free(delays);
+            }
+
+            return seq;
+        }
+
+        bool isNull() const {
+            return !m_d;
+        }
+
+        u32 width() const {
+            return m_width;
+        }
+
+        u32 height() const {
+            return m_height;
+        }
+
+        u32 frameCount() const {
+            return static_cast<u32>(m_delays.size());
+        }
+
+        // pixels per frame.
+        u32 framePixelCount() const {
+            return m_width * m_height;
+        }
+
+        // pixels of all frames.
+        u64 pixelCount() const {
+            return u64{frameCount()} * framePixelCount();
+        }
+
+        std::span<Pixel_t> frame(u32 idx) {
+            IMG_DEBUG_ASSERT(idx < frameCount(), "frame index out of range: %u, frame count: %u", idx, frameCount());
+            return {m_d + std::size_t{idx} * framePixelCount(), framePixelCount()};
+        }
+
+        std::span<const Pixel_t> frame(u32 idx) const {
+            IMG_DEBUG_ASSERT(idx < frameCount(), "frame index out of range: %u, frame count: %u", idx, frameCount());
+            return {m_d + std::size_t{idx} * framePixelCount(), framePixelCount()};
+        }
+
+        // how long frame `idx` is shown, in milliseconds.
+        u32 delay(u32 idx) const {
+            return m_delays[idx];
+        }
+
+        std::span<const u32> delays() const {
+            return m_delays;
+        }
+
+        // all frames, `frameCount() * framePixelCount()` pixels.
+        std::span<Pixel_t> pixels() {
+            return {m_d, std::size_t{frameCount()} * framePixelCount()};
+        }
+
+        std::span<const Pixel_t> pixels() const {
+            return {m_d, std::size_t{frameCount()} * framePixelCount()};
+        }
+
+        // a standalone copy of one frame, for the operations only `Image` has.
+        [[nodiscard]] Image<Pixel_t> frameImage(u32 idx) const {
+            Image<Pixel_t> ret{m_width, m_height};
+            if (!ret.isNull()) {
+                const std::span<const Pixel_t> src = frame(idx);
+                std::copy(src.begin(), src.end(), ret.begin());
+            }
+            return ret;
+        }
+
+        // `fn(std::span<Pixel_t> frame, u32 idx)` for every frame, frames run in parallel.
+        template<typename Fn>
+        FrameSequence& forEachFrame(Fn&& fn) {
+            parallelFor(0, frameCount(), 1, [&](u32 f0, u32 f1) {
+                for (u32 f = f0; f < f1; ++f) {
+                    fn(frame(f), f);
+                }
+            });
+            return *this;
+        }
+
+        FrameSequence& applyLut(const Lut& lut) {
+            return forEachFrame([&](std::span<Pixel_t> px, u32) {
+                detail::lutBytes(bytesOf(px), px.size(), pixel_traits<Pixel_t>::CHANNELS, lut);
+            });
+        }
+
+        FrameSequence& operator~() {
+            static const Lut INVERT = invertLut();
+            return applyLut(INVERT);
+        }
+
+        // frames are stacked rows of the same width, mirroring every row mirrors every frame.
+        FrameSequence& flipX() {
+            detail::flipColumns(reinterpret_cast<u8*>(m_d), m_width, m_height * frameCount(), sizeof(Pixel_t));
+            return *this;
+        }
+
+        FrameSequence& flipY() {
+            return forEachFrame([&](std::span<Pixel_t> px, u32) {
+                detail::flipRows(bytesOf(px), m_height, std::size_t{m_width} * sizeof(Pixel_t));
+            });
+        }
+
+    private:
+        void freePixels() {
+            if (m_d) {
+                stbi_image_free(m_d);
+                detail::releasePixels(pixels().size_bytes(), 1);
+            }
+        }
+
+        static u8* bytesOf(std::span<Pixel_t> px) {
+            return reinterpret_cast<u8*>(px.data());
+        }
+
+    private:
+        Pixel_t*         m_d      = nullptr;
+        u32              m_width  = 0;
+        u32              m_height = 0;
+        std::vector<u32> m_delays;
+    };
+
+} // namespace img
+
+#endif // LIB_IMG_FRAMES_H
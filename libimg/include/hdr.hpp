@@ -0,0 +1,202 @@
+#ifndef LIB_IMG_HDR_H
+#define LIB_IMG_HDR_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "color.hpp"
+#include "common.hpp"
+#include "img_assert.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // float -> 8-bit curves, both work per channel on linear light and the result is sRGB encoded.
+    enum ToneMapper : u8 {
+        TM_REINHARD = 0, // x (1 + x / white^2) / (1 + x), plain x / (1 + x) with an infinite white point
+        TM_ACES     = 1, // Narkowicz's fit of the ACES filmic curve
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    // the kernels below work on `C` floats per pixel, 3 (r, g, b) or 4 (r, g, b, a), alpha is never touched.
+
+    // px[c] *= gain[c] on the colour channels.
+    template<u32 C>
+    void scaleChannels(float* px, std::size_t pixels, const arr3<float>& gain) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        if constexpr (C == 3) {
+            // 8 pixels are 24 floats, the gain pattern repeats every three registers.
+            const __m256 g0 = _mm256_setr_ps(gain[0], gain[1], gain[2], gain[0], gain[1], gain[2], gain[0], gain[1]);
+            const __m256 g1 = _mm256_setr_ps(gain[2], gain[0], gain[1], gain[2], gain[0], gain[1], gain[2], gain[0]);
+            const __m256 g2 = _mm256_setr_ps(gain[1], gain[2], gain[0], gain[1], gain[2], gain[0], gain[1], gain[2]);
+            for (; i + 8 <= pixels; i += 8) {
+                float* p = px + i * 3;
+                _mm256_storeu_ps(p, _mm256_mul_ps(_mm256_loadu_ps(p), g0));
+                _mm256_storeu_ps(p + 8, _mm256_mul_ps(_mm256_loadu_ps(p + 8), g1));
+                _mm256_storeu_ps(p + 16, _mm256_mul_ps(_mm256_loadu_ps(p + 16), g2));
+            }
+        } else {
+            const __m256 g = _mm256_setr_ps(gain[0], gain[1], gain[2], 1.0f, gain[0], gain[1], gain[2], 1.0f);
+            for (; i + 2 <= pixels; i += 2) {
+                float* p = px + i * 4;
+                _mm256_storeu_ps(p, _mm256_mul_ps(_mm256_loadu_ps(p), g));
+            }
+        }
+#endif
+        for (float* p = px + i * C; i < pixels; ++i, p += C) {
+            p[0] *= gain[0];
+            p[1] *= gain[1];
+            p[2] *= gain[2];
+        }
+    }
+
+    // r = g = b = weight . (r, g, b).
+    template<u32 C>
+    void lumaPixels(float* px, std::size_t pixels, const arr3<float>& weight) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        if constexpr (C == 3) {
+            // three registers hold 8 interleaved pixels, a blend per channel gathers each channel's 8 values into
+            // one register (out of order, the same permutation for all three), the sum is spread back out by
+            // permutes.
+            const __m256i rIdx = _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5);
+            const __m256i gIdx = _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6);
+            const __m256i bIdx = _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7);
+            const __m256i o0   = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+            const __m256i o1   = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+            const __m256i o2   = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+            const __m256  wr   = _mm256_set1_ps(weight[0]);
+            const __m256  wg   = _mm256_set1_ps(weight[1]);
+            const __m256  wb   = _mm256_set1_ps(weight[2]);
+            for (; i + 8 <= pixels; i += 8) {
+                float*       p = px + i * 3;
+                const __m256 a = _mm256_loadu_ps(p);
+                const __m256 b = _mm256_loadu_ps(p + 8);
+                const __m256 c = _mm256_loadu_ps(p + 16);
+
+                const __m256 r = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x92), c, 0x24);
+                const __m256 g = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x24), c, 0x49);
+                const __m256 v = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x49), c, 0x92);
+
+                const __m256 y = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_permutevar8x32_ps(r, rIdx), wr),
+                                  _mm256_mul_ps(_mm256_permutevar8x32_ps(g, gIdx), wg)),
+                    _mm256_mul_ps(_mm256_permutevar8x32_ps(v, bIdx), wb));
+                _mm256_storeu_ps(p, _mm256_permutevar8x32_ps(y, o0));
+                _mm256_storeu_ps(p + 8, _mm256_permutevar8x32_ps(y, o1));
+                _mm256_storeu_ps(p + 16, _mm256_permutevar8x32_ps(y, o2));
+            }
+        } else {
+            // a dot product over the first three lanes of each pixel, written to the same three lanes.
+            const __m256 w
+                = _mm256_setr_ps(weight[0], weight[1], weight[2], 0.0f, weight[0], weight[1], weight[2], 0.0f);
+            for (; i + 2 <= pixels; i += 2) {
+                float*       p = px + i * 4;
+                const __m256 v = _mm256_loadu_ps(p);
+                _mm256_storeu_ps(p, _mm256_blend_ps(_mm256_dp_ps(v, w, 0x77), v, 0x88));
+            }
+        }
+#endif
+        for (float* p = px + i * C; i < pixels; ++i, p += C) {
+            p[0] = p[1] = p[2] = weight[0] * p[0] + weight[1] * p[1] + weight[2] * p[2];
+        }
+    }
+
+    // radiance files share one exponent between the three channels and have no sign, anything below 0 (or NaN)
+    // would come out as garbage. returns `px` when it's all representable, otherwise a copy with those set to 0.
+    inline const float* radianceSource(const float* px, std::size_t n, std::vector<float>& scratch) {
+        if (std::all_of(px, px + n, [](float v) { return v >= 0.0f; })) {
+            return px;
+        }
+
+        scratch.resize(n);
+        std::transform(px, px + n, scratch.begin(), [](float v) { return std::max(0.0f, v); });
+        return scratch.data();
+    }
+
+    // the argument order of max/min here and below matches the vector instructions: a NaN comes out as 0 from the
+    // lower bound and as 1 from the upper one, so it can't index past the encoding table.
+    template<ToneMapper TM>
+    float toneCurve(float x, float invWhite2) {
+        x = std::max(0.0f, x);
+        if constexpr (TM == TM_REINHARD) {
+            return x * (1.0f + x * invWhite2) / (1.0f + x);
+        } else {
+            return (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+        }
+    }
+
+#if LIB_IMG_AVX2
+    template<ToneMapper TM>
+    __m256 toneCurve(__m256 x, __m256 invWhite2) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        x                = _mm256_max_ps(x, _mm256_setzero_ps());
+        if constexpr (TM == TM_REINHARD) {
+            const __m256 num = _mm256_mul_ps(x, _mm256_add_ps(one, _mm256_mul_ps(x, invWhite2)));
+            return _mm256_div_ps(num, _mm256_add_ps(one, x));
+        } else {
+            const __m256 a   = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(2.51f)), _mm256_set1_ps(0.03f));
+            const __m256 b   = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(2.43f)), _mm256_set1_ps(0.59f));
+            const __m256 num = _mm256_mul_ps(x, a);
+            return _mm256_div_ps(num, _mm256_add_ps(_mm256_mul_ps(x, b), _mm256_set1_ps(0.14f)));
+        }
+    }
+#endif
+
+    inline u8 alphaToU8(float a) {
+        return static_cast<u8>(std::min(1.0f, std::max(0.0f, a)) * 255.0f + 0.5f);
+    }
+
+    // src (`C` floats per pixel) -> dst (`C` bytes per pixel): colour goes through `exposure`, the curve and the
+    // sRGB encoding table, alpha is only clamped to [0, 1] and scaled.
+    template<u32 C, ToneMapper TM>
+    void toneMapPixels(const float* src, u8* dst, std::size_t pixels, float exposure, float invWhite2) {
+        const std::array<u8, LAB_ENCODE_STEPS + 1>& srgb = linearToSrgbTable();
+
+        const std::size_t n = pixels * C;
+        std::size_t       i = 0;
+#if LIB_IMG_AVX2
+        // the curve is evaluated 8 floats at a time down to table indices, the lookup itself stays scalar.
+        const __m256 scale = _mm256_set1_ps(exposure);
+        const __m256 iw2   = _mm256_set1_ps(invWhite2);
+        const __m256 steps = _mm256_set1_ps(static_cast<float>(LAB_ENCODE_STEPS));
+        alignas(32) i32 index[8];
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = toneCurve<TM>(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), iw2);
+            v        = _mm256_min_ps(v, _mm256_set1_ps(1.0f)); // second operand on NaN
+            _mm256_store_si256(reinterpret_cast<__m256i*>(index), _mm256_cvtps_epi32(_mm256_mul_ps(v, steps)));
+            for (u32 k = 0; k < 8; ++k) {
+                dst[i + k] = (C == 4 && k % 4 == 3) ? alphaToU8(src[i + k]) : srgb[index[k]];
+            }
+        }
+#endif
+        // the vector loop can stop inside a pixel, the tail goes a float at a time too.
+        for (; i < n; ++i) {
+            if (C == 4 && i % 4 == 3) {
+                dst[i] = alphaToU8(src[i]);
+            } else {
+                const float v = std::min(1.0f, toneCurve<TM>(src[i] * exposure, invWhite2));
+                dst[i]        = srgb[static_cast<u32>(v * LAB_ENCODE_STEPS + 0.5f)];
+            }
+        }
+    }
+
+    template<u32 C>
+    void toneMapPixels(const float* src, u8* dst, std::size_t pixels, ToneMapper tm, float exposure,
+                       float invWhite2) {
+        switch (tm) {
+            case TM_REINHARD: toneMapPixels<C, TM_REINHARD>(src, dst, pixels, exposure, invWhite2); return;
+            case TM_ACES: toneMapPixels<C, TM_ACES>(src, dst, pixels, exposure, invWhite2); return;
+        }
+        IMG_ABORT("unsupported tone mapper: %u", tm);
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_HDR_H
@@ -1,17 +1,38 @@
 #ifndef LIB_IMG_IMAGE_H
 #define LIB_IMG_IMAGE_H
 
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <functional>
+#include <limits>
 #include <random>
-#include <unordered_map>
+#include <span>
 #include <utility>
+#include <vector>
 
+#include "color.hpp"
 #include "common.hpp"
+#include "composite.hpp"
+#include "edges.hpp"
+#include "flip.hpp"
+#include "format.hpp"
+#include "hdr.hpp"
 #include "img_assert.hpp"
+#include "lut.hpp"
+#include "median.hpp"
+#include "memory.hpp"
+#include "mix.hpp"
+#include "orientation.hpp"
+#include "morphology.hpp"
+#include "parallel.hpp"
 #include "pixel.hpp"
+#include "pixel_traits.hpp"
+#include "png16.hpp"
+#include "simd.hpp"
 #include "types.hpp"
 #include "utils.hpp"
+#include "warp.hpp"
 
 #include "stb_image.h"
 #include "stb_image_write.h"
@@ -30,23 +51,32 @@ namespace img {
 
     template<typename T>
         requires(is_pixel_type<T>)
-    inline u32 channelCountFromPixelType() {
-        if constexpr (std::is_same_v<T, GREY8>) {
-            return 1;
-        }
+    constexpr u32 channelCountFromPixelType() {
+        return pixel_traits<T>::CHANNELS;
+    }
 
-        if constexpr (std::is_same_v<T, GREYa8>) {
-            return 2;
-        }
+    namespace detail {
+        // the whole file, empty when it can't be read.
+        inline std::vector<u8> readFile(const fs::path& filePath) {
+            std::vector<u8> bytes;
 
-        if constexpr (std::is_same_v<T, RGB8> || std::is_same_v<T, BGR8>) {
-            return 3;
-        }
+            FILE* f = fopen(filePath.c_str(), "rb");
+            if (!f) {
+                return bytes;
+            }
 
-        if constexpr (std::is_same_v<T, RGBa8> || std::is_same_v<T, BGRa8>) {
-            return 4;
+            if (fseek(f, 0, SEEK_END) == 0) {
+                const long size = ftell(f);
+                if (size > 0 && fseek(f, 0, SEEK_SET) == 0) {
+                    bytes.resize(static_cast<std::size_t>(size));
+                    bytes.resize(fread(bytes.data(), 1, bytes.size(), f));
+                }
+            }
+
+            fclose(f);
+            return bytes;
         }
-    }
+    } // namespace detail
 
     template<typename Pixel>
     class LIB_IMG_PUBLIC Image {
@@ -54,113 +84,104 @@ namespace img {
         template<class U>
         friend class Image;
 
-        enum ImageFmt : u16 {
-            IF_UNKOWN = 0X000,
-            IF_JPEG   = 0x001,
-            IF_JPG    = 0x002,
-            IF_PNG    = 0x004,
-            IF_BMP    = 0x008,
-            IF_PSD    = 0x010,
-            IF_TGA    = 0x020,
-            IF_GIF    = 0x040,
-            IF_HDR    = 0x080,
-            IF_PIC    = 0x100,
-            IF_PNM    = 0x200,
-        };
-
-        enum PixelFmt : u16 {
-            PF_UNKOWN = 0X0000,
-            PF_GREY8  = 0x0001,
-            PF_GREYa8 = 0x0002,
-            PF_RGB8   = 0x0004,
-            PF_RGBa8  = 0x0020,
-            PF_BGR8   = 0x0100,
-            PF_BGRa8  = 0x0800,
-        };
-
-        enum ChannelCountMask : u16 {
-            M_1C = PF_GREY8,
-            M_2C = PF_GREY8 | PF_GREYa8,
-            M_3C = PF_RGB8 | PF_BGR8,
-            M_4C = PF_RGBa8 | PF_BGRa8,
-        };
-
     public:
         using Pixel_t         = Pixel;
+        using Channel_t       = pixel_channel_t<Pixel>;
         using Iterator_t      = Pixel*;
         using ConstIterator_t = const Pixel*;
 
+        // what `greyScaleAvg()` and `greyScaleLum()` produce: grey of the same depth keeping alpha, float stays float.
+        using Grey_t = std::conditional_t<
+            is_hdr_pixel<Pixel>,
+            Pixel,
+            std::conditional_t<sizeof(Channel_t) == 1,
+                               std::conditional_t<pixel_traits<Pixel>::HAS_ALPHA, GREYa8, GREY8>,
+                               std::conditional_t<pixel_traits<Pixel>::HAS_ALPHA, GREYa16, GREY16>>>;
+
         Image() : m_d(nullptr), m_width(0), m_height(0), m_pixelCount(0) {
         }
 
     public:
+        // a null image when the memory budget refuses the pixels under MB_FAIL, see `setMemoryBudget()`. the same
+        // goes for copies.
         Image(uint32_t width, uint32_t height)
             : m_d(nullptr),
               m_width(width),
               m_height(height),
               m_pixelCount(width * height) {
-            m_d = new Pixel_t[m_pixelCount];
+            m_d = detail::allocatePixels<Pixel_t>(m_pixelCount);
+            if (!m_d) {
+                becomeNull();
+            }
         }
 
-        Image(uint32_t width, uint32_t height, Pixel_t fillColor)
-            : m_d(nullptr),
-              m_width(width),
-              m_height(height),
-              m_pixelCount(width * height) {
-            m_d = new Pixel_t[m_pixelCount];
+        Image(uint32_t width, uint32_t height, Pixel_t fillColor) : Image(width, height) {
             fill(fillColor);
         }
 
-        Image(const fs::path& filePath) : m_d(nullptr) {
+        Image(const fs::path& filePath) : Image() {
+            IMG_OP_SCOPE("load", *this);
             if (!fs::exists(filePath)) {
                 IMG_ABORT("file does not exist: %s", filePath.c_str());
             }
 
-            u8* d;
-            int w, h, c;
-            if ((d = stbi_load(filePath.c_str(), &w, &h, &c, 0))) {
-                m_width  = static_cast<u32>(w);
-                m_height = static_cast<u32>(h);
-
-                IMG_DEBUG_ASSERT((m_width * m_height) <= LIB_IMG_MAX_SIZE,
-                                 "Image %s pixel count exceeded `LIB_IMG_MAX_SIZE`: %u, image pixel count: %d"
-                                 "are you sure this file is valid?",
-                                 filePath.c_str(),
-                                 LIB_IMG_MAX_SIZE,
-                                 m_width * m_height);
-
-                m_pixelCount = m_width * m_height;
-
-                m_d = new Pixel_t[m_pixelCount];
-
-                std::copy(d, d + (m_pixelCount * c), reinterpret_cast<u8*>(m_d));
-                stbi_image_free(d);
-            } else {
-                IMG_ABORT("stb couldn't load image file: %s", filePath.c_str());
+            if (!decodeFile(filePath)) {
+                IMG_ABORT("stb couldn't load image file, or it exceeds the memory budget: %s", filePath.c_str());
             }
         }
 
-        Image(const Image& other) : m_width(other.m_width), m_height(other.m_height), m_pixelCount(m_width * m_height) {
-            m_d = new Pixel_t[m_pixelCount];
+        Image(const Image& other)
+            : m_width(other.m_width),
+              m_height(other.m_height),
+              m_pixelCount(m_width * m_height),
+              m_orientation(other.m_orientation) {
+            m_d = detail::allocatePixels<Pixel_t>(m_pixelCount);
+            if (!m_d) {
+                becomeNull();
+                return;
+            }
             std::copy(other.m_d, other.m_d + other.pixelCount(), m_d);
         }
 
-        Image(Image&& other)
+        Image(Image&& other) noexcept
             : m_d(std::move(other.m_d)),
               m_width(std::move(other.m_width)),
               m_height(std::move(other.m_height)),
-              m_pixelCount(std::move(other.m_pixelCount)) {
+              m_pixelCount(std::move(other.m_pixelCount)),
+              m_orientation(other.m_orientation) {
             other.m_d = nullptr;
         }
 
         ~Image() {
             if (m_d) {
-                delete[] m_d;
+                detail::freePixels(m_d);
             }
         }
 
+        // same as `Image(filePath)` but returns a null image instead of aborting when the file can't be decoded or the
+        // memory budget refuses it.
+        [[nodiscard]] static Image tryLoad(const fs::path& filePath) {
+            Image img;
+            IMG_OP_SCOPE("tryLoad", img);
+            img.decodeFile(filePath);
+            return img;
+        }
+
+        // decodes an in-memory encoded file, returns a null image on failure.
+        [[nodiscard]] static Image tryLoad(std::span<const u8> encoded) {
+            Image img;
+            IMG_OP_SCOPE("tryLoad", img);
+            img.decode(encoded);
+            return img;
+        }
+
+        // zero filled, `pf` has to name this image's own pixel type, `AnyImage::creatBlankImage()` takes any.
         static Image creatBlankImage(uint32_t width, uint32_t height, PixelFmt pf) {
-            IMG_ABORT("Unimplemented");
+            IMG_ASSERT(pf == pixel_traits<Pixel_t>::FORMAT,
+                       "pixel format mismatch: %s image requested as %s",
+                       pixelFmtName(pixel_traits<Pixel_t>::FORMAT),
+                       pixelFmtName(pf));
+            return Image(width, height, Pixel_t{});
         }
 
         template<typename T>
@@ -176,35 +197,43 @@ namespace img {
         }
 
         Image& operator=(const Image& other) {
+            IMG_OP_SCOPE("copy", *this);
             if (this == &other) {
                 return *this;
             }
 
-            m_width      = other.m_width;
-            m_height     = other.m_height;
-            m_pixelCount = other.m_pixelCount;
-
-            if (m_d) {
-                delete[] m_d;
+            // an image of the same pixel count keeps its buffer, assigning frames of one size allocates nothing.
+            if (!m_d || m_pixelCount != other.m_pixelCount) {
+                detail::freePixels(m_d);
+                m_d = detail::allocatePixels<Pixel_t>(other.m_pixelCount);
+                if (!m_d) {
+                    becomeNull();
+                    return *this;
+                }
             }
 
-            m_d = new Pixel_t[m_pixelCount];
+            m_width       = other.m_width;
+            m_height      = other.m_height;
+            m_pixelCount  = other.m_pixelCount;
+            m_orientation = other.m_orientation;
+
             std::copy(other.m_d, other.m_d + other.pixelCount(), m_d);
 
             return *this;
         }
 
-        Image& operator=(Image&& other) {
+        Image& operator=(Image&& other) noexcept {
             if (this == &other) {
                 return *this;
             }
 
-            m_width      = std::move(other.m_width);
-            m_height     = std::move(other.m_height);
-            m_pixelCount = std::move(other.m_pixelCount);
+            m_width       = std::move(other.m_width);
+            m_height      = std::move(other.m_height);
+            m_pixelCount  = std::move(other.m_pixelCount);
+            m_orientation = other.m_orientation;
 
             if (m_d) {
-                delete[] m_d;
+                detail::freePixels(m_d);
                 m_d = nullptr;
             }
 
@@ -214,20 +243,39 @@ namespace img {
             return *this;
         }
 
-        Image& operator~() {
-            std::for_each(m_d, m_d + m_pixelCount, [](Pixel_t& p) { ~p; });
-            return *this;
+        // inverts the colour channels and keeps alpha, 8-bit pixels go through the LUT engine.
+        Image& operator~()
+            requires std::is_integral_v<pixel_channel_t<Pixel_t>>
+        {
+            if constexpr (is_color_8_bit_depth<Pixel_t>) {
+                static const Lut INVERT = invertLut();
+                return applyLut(INVERT);
+            } else {
+                IMG_OP_SCOPE("operator~", *this);
+                std::for_each(m_d, m_d + m_pixelCount, [](Pixel_t& p) { ~p; });
+                return *this;
+            }
         }
 
         Pixel_t& operator[](u32 idx) {
+            resolveOrientation();
             return m_d[idx];
         }
 
         Pixel_t& operator[](u32 x, u32 y) {
+            resolveOrientation();
             return m_d[(m_width * y) + x];
         }
 
         [[nodiscard]] Image friend operator+(const Image& LHS, const Image& RHS) {
+            IMG_OP_SCOPE("operator+", LHS);
+            LHS.resolveOrientation();
+            RHS.resolveOrientation();
+            if (LHS.m_width == RHS.m_width && LHS.m_height == RHS.m_height) {
+                Image ret{LHS.m_width, LHS.m_height};
+                add(LHS, RHS, ret);
+                return ret;
+            }
             uint32_t w_max = LHS.width() > RHS.width() ? LHS.width() : RHS.width();
             uint32_t h_max = LHS.height() > RHS.height() ? LHS.height() : RHS.height();
             Image    ret{w_max, h_max};
@@ -244,6 +292,14 @@ namespace img {
         }
 
         [[nodiscard]] Image friend operator-(const Image& LHS, const Image& RHS) {
+            IMG_OP_SCOPE("operator-", LHS);
+            LHS.resolveOrientation();
+            RHS.resolveOrientation();
+            if (LHS.m_width == RHS.m_width && LHS.m_height == RHS.m_height) {
+                Image ret{LHS.m_width, LHS.m_height};
+                subtract(LHS, RHS, ret);
+                return ret;
+            }
             u32   w_max = LHS.width() > RHS.width() ? LHS.width() : RHS.width();
             u32   h_max = LHS.height() > RHS.height() ? LHS.height() : RHS.height();
             Image ret{w_max, h_max};
@@ -259,20 +315,35 @@ namespace img {
             return ret;
         }
 
+        // `LHS + RHS` of two images of the same size written into `dst` (the same size again, either operand works),
+        // nothing is allocated.
+        static Image& add(const Image& LHS, const Image& RHS, Image& dst) {
+            IMG_OP_SCOPE("add", dst);
+            return laneArithmetic<typename simd::ChannelOps<Channel_t>::Add>(LHS, RHS, dst);
+        }
+
+        static Image& subtract(const Image& LHS, const Image& RHS, Image& dst) {
+            IMG_OP_SCOPE("subtract", dst);
+            return laneArithmetic<typename simd::ChannelOps<Channel_t>::Sub>(LHS, RHS, dst);
+        }
+
         const Pixel_t& pixelAt(u32 idx) const {
+            resolveOrientation();
             return m_d[idx];
         }
 
         const Pixel_t& pixelAt(u32 x, u32 y) const {
+            resolveOrientation();
             return m_d[(m_width * y) + x];
         }
 
+        // dimensions as displayed, a pending quarter turn already counts.
         u32 height() const {
-            return m_height;
+            return (m_orientation & OR_TRANSPOSE) ? m_width : m_height;
         };
 
         u32 width() const {
-            return m_width;
+            return (m_orientation & OR_TRANSPOSE) ? m_height : m_width;
         };
 
         u32 chanelCount() const {
@@ -288,22 +359,28 @@ namespace img {
         }
 
         Iterator_t begin() {
+            resolveOrientation();
             return m_d;
         }
 
         ConstIterator_t begin() const {
+            resolveOrientation();
             return m_d;
         }
 
         Iterator_t end() {
+            resolveOrientation();
             return m_d;
         }
 
         ConstIterator_t end() const {
+            resolveOrientation();
             return m_d;
         }
 
         bool save(fs::path filePath, bool png_for_unsupported_format = true) const {
+            IMG_OP_SCOPE("save", *this);
+            resolveOrientation();
             if (!filePath.has_filename() || !filePath.has_extension()) {
                 IMG_ABORT("Invalid image path: %s", filePath.c_str());
             }
@@ -313,12 +390,51 @@ namespace img {
             int h = static_cast<int>(m_height);
             int c = static_cast<int>(channelCountFromPixelType<Pixel_t>());
 
+            // float pixels can only be written as radiance files, the fallback for them is ".hdr" instead of ".png".
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                if (getImageFormat(filePath) != IF_HDR) {
+                    if (!png_for_unsupported_format) {
+                        IMG_ABORT("float pixels can only be saved as \".hdr\": %s", filePath.extension().c_str());
+                    }
+                    IMG_LOG_WARN("float pixels can only be saved as \".hdr\", got \"%s\"",
+                                 filePath.extension().c_str());
+                    filePath.replace_extension(".hdr");
+                }
+                std::vector<float> scratch;
+                const float*       src = detail::radianceSource(channelData(), byteCount() / sizeof(float), scratch);
+                ret                    = stbi_write_hdr(filePath.c_str(), w, h, c, src);
+                return ret != 0;
+            }
+
+            // 16-bit pixels only go out as 16-bit png, anything else would drop the low byte.
+            if constexpr (is_color_16_bit_depth<Pixel_t>) {
+                if (getImageFormat(filePath) != IF_PNG) {
+                    if (!png_for_unsupported_format) {
+                        IMG_ABORT("16-bit pixels can only be saved as \".png\": %s", filePath.extension().c_str());
+                    }
+                    IMG_LOG_WARN("16-bit pixels can only be saved as \".png\", got \"%s\"",
+                                 filePath.extension().c_str());
+                    filePath.replace_extension(".png");
+                }
+                std::vector<u8> png;
+                if (!detail::encodePng16(channelData(), m_width, m_height, CHANNELS, png)) {
+                    IMG_LOG_WARN("failed to encode \"%s\"", filePath.c_str());
+                    return false;
+                }
+                FILE* f = std::fopen(filePath.c_str(), "wb");
+                if (!f) {
+                    IMG_LOG_WARN("failed to open \"%s\" for writing", filePath.c_str());
+                    return false;
+                }
+                const bool written = std::fwrite(png.data(), 1, png.size(), f) == png.size();
+                return (std::fclose(f) == 0) && written;
+            }
+
             // clang-format off
             switch (getImageFormat(filePath)) {
                 case IF_JPG:
                 case IF_JPEG: ret = stbi_write_jpg(filePath.c_str(), w, h, c, reinterpret_cast<u8*>(m_d), 100);   break;
                 case IF_PNG:  ret = stbi_write_png(filePath.c_str(), w, h, c, reinterpret_cast<u8*>(m_d), w * c); break;
-                // case IF_HDR: break;
                 default:
                     if (png_for_unsupported_format /* allow implicit conversion on unsupported format ??*/) {
                         IMG_LOG_WARN("saving \"%s\" extension is not supported, defaulting to \".png\"", filePath.extension().c_str());
@@ -339,211 +455,489 @@ namespace img {
             return true;
         }
 
-        Image& colorMask(float r, float g, float b) {
-            std::for_each(m_d, m_d + m_pixelCount, [&r, &g, &b](Pixel_t& p) { p *= arr3<float>{r, g, b}; });
+        // encodes the pixels the way `save(filePath)` would, without touching the disk, empty on failure.
+        [[nodiscard]] std::vector<u8> encode(const fs::path& filePath) const {
+            IMG_OP_SCOPE("encode", *this);
+            resolveOrientation();
+            std::vector<u8> out;
+
+            int w = static_cast<int>(m_width);
+            int h = static_cast<int>(m_height);
+            int c = static_cast<int>(channelCountFromPixelType<Pixel_t>());
+
+            auto write = [](void* ctx, void* data, int size) {
+                auto* dst   = static_cast<std::vector<u8>*>(ctx);
+                auto* bytes = static_cast<u8*>(data);
+                dst->insert(dst->end(), bytes, bytes + size);
+            };
+
+            int ret = 0;
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                std::vector<float> scratch;
+                ret = stbi_write_hdr_to_func(
+                    write, &out, w, h, c, detail::radianceSource(channelData(), byteCount() / sizeof(float), scratch));
+                if (!ret) {
+                    out.clear();
+                }
+                return out;
+            }
+
+            // 16-bit pixels are always encoded as png, see `save()`.
+            if constexpr (is_color_16_bit_depth<Pixel_t>) {
+                if (!detail::encodePng16(channelData(), m_width, m_height, CHANNELS, out)) {
+                    out.clear();
+                }
+                return out;
+            }
+
+            // clang-format off
+            switch (getImageFormat(filePath)) {
+                case IF_JPG:
+                case IF_JPEG: ret = stbi_write_jpg_to_func(write, &out, w, h, c, reinterpret_cast<u8*>(m_d), 100);   break;
+                case IF_UNKOWN:
+                case IF_PNG:
+                case IF_BMP:
+                case IF_PSD:
+                case IF_TGA:
+                case IF_GIF:
+                case IF_HDR:
+                case IF_PIC:
+                case IF_PNM:  ret = stbi_write_png_to_func(write, &out, w, h, c, reinterpret_cast<u8*>(m_d), w * c); break;
+            }
+            // clang-format on
+
+            if (!ret) {
+                out.clear();
+            }
+
+            return out;
+        }
+
+        Image& colorMask(float r, float g, float b)
+            requires(!is_grey_scale_pixel<Pixel_t>)
+        {
+            IMG_OP_SCOPE("colorMask", *this);
+            if constexpr (is_color_16_bit_depth<Pixel_t>) {
+                const arr3<float> gain = inMemoryOrder(arr3<float>{r, g, b});
+                parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                    detail::gainChannels<CHANNELS>(channelData() + std::size_t{y0} * m_width * CHANNELS,
+                                                   std::size_t{y1 - y0} * m_width,
+                                                   gain);
+                });
+                return *this;
+            } else if constexpr (is_hdr_pixel<Pixel_t>) {
+                const arr3<float> gain{r, g, b};
+                parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                    detail::scaleChannels<CHANNELS>(channelData() + std::size_t{y0} * m_width * CHANNELS,
+                                                  std::size_t{y1 - y0} * m_width,
+                                                  gain);
+                });
+                return *this;
+            } else {
+                return applyLut(gainLut(r), gainLut(g), gainLut(b));
+            }
+        }
+
+        // float -> 8-bit with `tm`, colour is multiplied by `exposure` first and `white` (the value that maps to
+        // full white) is only used by TM_REINHARD. HDR32 becomes RGB8, HDRa32 RGBa8 with alpha scaled.
+        [[nodiscard]] auto toneMap(ToneMapper tm       = TM_REINHARD,
+                                   float      exposure = 1.0f,
+                                   float      white    = std::numeric_limits<float>::infinity()) const
+            requires is_hdr_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("toneMap", *this);
+            IMG_ASSERT(white > 0.0f, "tone mapping white point must be positive, got %f", static_cast<double>(white));
+            using Ldr_t = std::conditional_t<CHANNELS == 4, RGBa8, RGB8>;
+
+            Image<Ldr_t> ret{m_width, m_height};
+            ret.m_orientation = m_orientation;
+
+            const float invWhite2 = 1.0f / (white * white);
+            parallelFor(0, m_height, 32, [&](u32 y0, u32 y1) {
+                const std::size_t offset = std::size_t{y0} * m_width * CHANNELS;
+                detail::toneMapPixels<CHANNELS>(channelData() + offset,
+                                              ret.bytes() + offset,
+                                              std::size_t{y1 - y0} * m_width,
+                                              tm,
+                                              exposure,
+                                              invWhite2);
+            });
+            return ret;
+        }
+
+        // maps every colour channel through `lut`, alpha is kept. chains of point operations should be folded with
+        // `composeLuts` first so the pixels are only touched once.
+        Image& applyLut(const Lut& lut)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("applyLut", *this);
+            const u32 channels = channelCountFromPixelType<Pixel_t>();
+            parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                const std::size_t offset = std::size_t{y0} * m_width * channels;
+                detail::lutBytes(bytes() + offset, std::size_t{y1 - y0} * m_width, channels, lut);
+            });
+            return *this;
+        }
+
+        // one table per colour channel, matched by field name so BGR pixels take the same arguments.
+        Image& applyLut(const Lut& r, const Lut& g, const Lut& b)
+            requires(is_3_channel_pixel<Pixel_t> || is_4_channel_pixel<Pixel_t>)
+        {
+            IMG_OP_SCOPE("applyLut", *this);
+            if (r == g && g == b) {
+                return applyLut(r);
+            }
+
+            const std::array<const Lut*, 3> luts = inMemoryOrder(std::array<const Lut*, 3>{&r, &g, &b});
+            parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                detail::lutPixels<sizeof(Pixel_t)>(
+                    bytes() + std::size_t{y0} * m_width * sizeof(Pixel_t), std::size_t{y1 - y0} * m_width, luts);
+            });
             return *this;
         }
 
         Image& fill(const Pixel_t fillColor) {
+            IMG_OP_SCOPE("fill", *this);
+            // every pixel gets the same value, so a pending orientation only has to settle the dimensions.
+            if (m_orientation & OR_TRANSPOSE) {
+                std::swap(m_width, m_height);
+            }
+            m_orientation = OR_IDENTITY;
+
             std::for_each(m_d, m_d + m_pixelCount, [&fillColor](Pixel_t& p) { p = fillColor; });
             return *this;
         }
 
+        // flips and quarter turns are recorded and composed in O(1), the pixels are rearranged in a single pass the
+        // first time anything reads them or an op that depends on pixel positions runs, see `materialize()`.
         Image& flipX() {
-            for (u32 y = 0; y < m_height; ++y) {
-                for (u32 x = 0; x < (m_width / 2); ++x) {
-                    u32 idx    = (m_width * y) + x;
-                    u32 op_idx = (m_width * y) + (m_width - 1 - x);
-                    std::swap(m_d[idx], m_d[op_idx]);
-                }
-            }
-            return *this;
+            return orient(OR_FLIP_X);
         }
 
         Image& flipY() {
-            for (u32 y = 0; y < (m_height / 2); ++y) {
-                for (u32 x = 0; x < m_width; ++x) {
-                    u32 idx    = (m_width * y) + x;
-                    u32 op_idx = (m_width * (m_height - 1 - y)) + x;
-                    std::swap(m_d[idx], m_d[op_idx]);
-                }
-            }
-            return *this;
+            return orient(OR_FLIP_Y);
         }
 
         Image& rotateRight() {
-            Pixel_t* oldPixels = m_d;
-            m_d                = new Pixel_t[m_pixelCount];
+            return orient(OR_ROTATE_RIGHT);
+        }
 
-            for (u32 x = 0, idx = 0; x < m_width; ++x) {
-                for (u32 y = 0; y < m_height; ++y, ++idx) {
-                    u32 oldIdx = (m_width * y) + x;
-                    m_d[idx]   = oldPixels[oldIdx];
-                }
-            }
+        Image& rotateLeft() {
+            return orient(OR_ROTATE_LEFT);
+        }
 
-            std::swap(m_width, m_height);
-            delete[] oldPixels;
+        Image& orient(Orientation orientation) {
+            m_orientation = composeOrientation(m_orientation, orientation);
+            return *this;
+        }
 
-            flipX();
+        // what's still pending, OR_IDENTITY once materialised.
+        Orientation orientation() const {
+            return m_orientation;
+        }
 
+        // forgets the pending orientation without moving a pixel, the image shows its buffer as stored again. for
+        // buffers whose contents no longer matter, a recycled frame or a destination about to be overwritten.
+        Image& dropOrientation() {
+            m_orientation = OR_IDENTITY;
             return *this;
         }
 
-        Image& rotateLeft() {
-            Pixel_t* oldPixels = m_d;
-            m_d                = new Pixel_t[m_pixelCount];
+        // applies the pending orientation to the pixel buffer now.
+        Image& materialize() {
+            resolveOrientation();
+            return *this;
+        }
 
-            for (u32 x = 0, idx = 0; x < m_width; ++x) {
-                for (u32 y = 0; y < m_height; ++y, ++idx) {
-                    u32 oldIdx = (m_width * (m_height - y - 1) + (m_width - 1 - x));
-                    m_d[idx]   = oldPixels[oldIdx];
-                }
-            }
+        // `transform` maps source pixels to the destination, which is `width` x `height`.
+        [[nodiscard]] Image warpAffine(const AffineTransform& transform,
+                                       u32                    width,
+                                       u32                    height,
+                                       Interpolation          interpolation = IP_BILINEAR,
+                                       BorderMode             border        = BM_CONSTANT,
+                                       Pixel_t                borderColor   = {}) const
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("warpAffine", *this);
+            return warped(transform.inverted(), width, height, interpolation, border, borderColor);
+        }
 
-            std::swap(m_width, m_height);
-            delete[] oldPixels;
+        [[nodiscard]] Image warpPerspective(const PerspectiveTransform& transform,
+                                            u32                         width,
+                                            u32                         height,
+                                            Interpolation               interpolation = IP_BILINEAR,
+                                            BorderMode                  border        = BM_CONSTANT,
+                                            Pixel_t                     borderColor   = {}) const
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("warpPerspective", *this);
+            return warped(transform.inverted(), width, height, interpolation, border, borderColor);
+        }
 
-            flipX();
+        // rotates by an arbitrary angle around the image centre, counter-clockwise as displayed, keeping the size.
+        Image& rotate(double        degrees,
+                      Interpolation interpolation = IP_BILINEAR,
+                      BorderMode    border        = BM_CONSTANT,
+                      Pixel_t       borderColor   = {})
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("rotate", *this);
+            resolveOrientation();
+            const auto transform = AffineTransform::rotation(degrees, (m_width - 1) / 2.0, (m_height - 1) / 2.0);
+            *this = warped(transform.inverted(), m_width, m_height, interpolation, border, borderColor);
+            return *this;
+        }
 
+        // scales colour by alpha, which `composite()` expects of both images.
+        Image& premultiply()
+            requires is_4_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("premultiply", *this);
+            parallelFor(0, m_height, 64, [this](u32 y0, u32 y1) {
+                detail::premultiplyRow(bytes() + std::size_t{y0} * m_width * 4, std::size_t{y1 - y0} * m_width);
+            });
             return *this;
         }
 
-        Image& addGaussianNoise(float mean, float dev) {
-            auto gen = std::bind(std::normal_distribution<float>{mean, dev}, std::mt19937(std::random_device{}()));
-            if constexpr (is_1_channel_pixel<Pixel_t> || is_1_channel_pixel<Pixel_t>) {
-                std::for_each(
-                    m_d, m_d + m_pixelCount, [&gen](Pixel_t& p) { p.g = clampColorChanel<Pixel_t>(p.g + gen()); });
-            }
+        Image& unpremultiply()
+            requires is_4_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("unpremultiply", *this);
+            parallelFor(0, m_height, 64, [this](u32 y0, u32 y1) {
+                detail::unpremultiplyRow(bytes() + std::size_t{y0} * m_width * 4, std::size_t{y1 - y0} * m_width);
+            });
+            return *this;
+        }
+
+        // blends premultiplied `overlay` onto this premultiplied image with its top-left corner at (x, y), the
+        // part falling outside is clipped and nothing is allocated.
+        Image& composite(const Image& overlay, i32 x, i32 y, BlendMode mode = BL_NORMAL)
+            requires is_4_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("composite", *this);
+            resolveOrientation();
+            overlay.resolveOrientation();
 
-            if constexpr (is_3_channel_pixel<Pixel_t> || is_4_channel_pixel<Pixel_t>) {
-                std::for_each(m_d, m_d + m_pixelCount, [&gen](Pixel_t& p) { p += arr3<float>{gen(), gen(), gen()}; });
+            const i64 x0 = std::max<i64>(x, 0), x1 = std::min<i64>(i64{x} + overlay.m_width, m_width);
+            const i64 y0 = std::max<i64>(y, 0), y1 = std::min<i64>(i64{y} + overlay.m_height, m_height);
+            if (x0 >= x1 || y0 >= y1) {
+                return *this;
             }
 
+            const std::size_t n = static_cast<std::size_t>(x1 - x0);
+            parallelFor(static_cast<u32>(y0), static_cast<u32>(y1), 64, [&](u32 r0, u32 r1) {
+                for (u32 row = r0; row < r1; ++row) {
+                    u8*       dst = bytes() + (std::size_t{row} * m_width + x0) * 4;
+                    const u8* src = overlay.bytes() + ((row - i64{y}) * overlay.m_width + (x0 - x)) * 4;
+                    detail::blendRow(dst, src, n, mode);
+                }
+            });
+
             return *this;
         }
 
-        [[nodiscard]] auto addSaltAndPepperNoise(float prob, float randBotLimit, float randTopLimit) {
+        // colour space conversions in place, the r, g, b fields carry the converted components in order (Y Cb Cr,
+        // H S V, H S L, L a b), see color.hpp for the 8-bit encodings.
+        Image& rgbToYCbCr(YCbCrMatrix matrix = YCC_BT601, YCbCrRange range = YCC_FULL_RANGE)
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("rgbToYCbCr", *this);
+            const detail::ColorMatrix cm = detail::yCbCrForward(matrix, range);
+            return convertColor([&cm](u8* px, std::size_t n, const detail::ChannelOrder& order) {
+                detail::colorMatrixPixels(px, n, cm, order);
+            });
+        }
 
-            auto gen = std::bind(std::uniform_real_distribution(randBotLimit, randTopLimit),
-                                 std::mt19937(std::random_device{}()));
+        Image& yCbCrToRgb(YCbCrMatrix matrix = YCC_BT601, YCbCrRange range = YCC_FULL_RANGE)
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("yCbCrToRgb", *this);
+            const detail::ColorMatrix cm = detail::yCbCrInverse(matrix, range);
+            return convertColor([&cm](u8* px, std::size_t n, const detail::ChannelOrder& order) {
+                detail::colorMatrixPixels(px, n, cm, order);
+            });
+        }
 
-            if constexpr (is_3_channel_pixel<Pixel_t>) {
-                auto img = greyScaleLum();
-                std::for_each(img.m_d, img.m_d + img.pixelCount(), [&gen, &prob](GREY8& p) {
-                    float rand = gen();
-                    if (rand < (prob / 2)) {
-                        p.g = 255;
-                    } else if (rand > (1 - (prob / 2))) {
-                        p.g = 0;
+        Image& rgbToHsv()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("rgbToHsv", *this);
+            return convertColor(detail::rgbToHsvPixels);
+        }
+
+        Image& hsvToRgb()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("hsvToRgb", *this);
+            return convertColor(detail::hsvToRgbPixels);
+        }
+
+        Image& rgbToHsl()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("rgbToHsl", *this);
+            return convertColor(detail::rgbToHslPixels);
+        }
+
+        Image& hslToRgb()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("hslToRgb", *this);
+            return convertColor(detail::hslToRgbPixels);
+        }
+
+        // sRGB against the D65 white point.
+        Image& rgbToLab()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("rgbToLab", *this);
+            return convertColor(detail::rgbToLabPixels);
+        }
+
+        Image& labToRgb()
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("labToRgb", *this);
+            return convertColor(detail::labToRgbPixels);
+        }
+
+        Image& addGaussianNoise(float mean, float dev) {
+            IMG_OP_SCOPE("addGaussianNoise", *this);
+            auto gen = std::bind(std::normal_distribution<float>{mean, dev}, std::mt19937(std::random_device{}()));
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                // the generator is sequential, the samples are drawn a block at a time (alpha lanes stay 0) and
+                // added with the vector kernel, nothing is clamped.
+                constexpr std::size_t BLOCK = 1024;
+
+                std::vector<float> noise(BLOCK * CHANNELS, 0.0f);
+                for (std::size_t i = 0; i < m_pixelCount; i += BLOCK) {
+                    const std::size_t n = std::min<std::size_t>(BLOCK, m_pixelCount - i);
+                    for (std::size_t p = 0; p < n; ++p) {
+                        noise[p * CHANNELS]     = gen();
+                        noise[p * CHANNELS + 1] = gen();
+                        noise[p * CHANNELS + 2] = gen();
                     }
-                });
-                return img;
+                    float* px = channelData() + i * CHANNELS;
+                    simd::apply<simd::AddF32>(px, px, noise.data(), n * CHANNELS);
+                }
             }
 
-            if constexpr (is_4_channel_pixel<Pixel_t>) {
-                auto img = greyScaleLum();
-                std::for_each(img.m_d, img.m_d + img.pixelCount(), [&gen, &prob](GREYa8& p) {
-                    float rand = gen();
-                    if (rand < (prob / 2)) {
-                        p.g = 255;
-                    } else if (rand > (1 - (prob / 2))) {
-                        p.g = 0;
+            if constexpr (!is_hdr_pixel<Pixel_t>) {
+                // in channel units, rounded and saturated. alpha is kept.
+                constexpr u32 COLOUR = pixel_traits<Pixel_t>::COLOUR_CHANNELS;
+
+                Channel_t* end = channelData() + std::size_t{m_pixelCount} * CHANNELS;
+                for (Channel_t* p = channelData(); p != end; p += CHANNELS) {
+                    for (u32 c = 0; c < COLOUR; ++c) {
+                        p[c] = clampColorChanel<Pixel_t>(p[c] + gen() + 0.5f);
                     }
-                });
-                return img;
+                }
             }
 
-            UNREACHABLE();
+            return *this;
         }
 
-        [[nodiscard]] auto greyScaleAvg()
-            requires(!is_grey_scale_pixel<Pixel_t>)
+        [[nodiscard]] auto addSaltAndPepperNoise(float prob, float randBotLimit, float randTopLimit)
+            requires(!is_grey_scale_pixel<Pixel_t> && !is_hdr_pixel<Pixel_t>)
         {
-            const float rf = .2126f, gf = .7152f, bf = .0722f;
-            if constexpr (is_4_channel_pixel<Pixel_t>) {
-                Image<GREYa8> ret{m_width, m_height};
-                u32           i = 0;
-                std::for_each(ret.m_d, ret.m_d + ret.pixelCount(), [this, &i, &rf, &gf, &bf](GREYa8& p) {
-                    p = GREYa8{.g = clampColorChanel<Pixel_t>((m_d[i].r + m_d[i].g + m_d[i].b) / 3.), .a = m_d[i].a};
-                    ++i;
-                });
-                return ret;
-            }
+            IMG_OP_SCOPE("addSaltAndPepperNoise", *this);
+            auto gen = std::bind(std::uniform_real_distribution(randBotLimit, randTopLimit),
+                                 std::mt19937(std::random_device{}()));
 
-            if constexpr (is_3_channel_pixel<Pixel_t>) {
-                Image<GREY8> ret{m_width, m_height};
-                u32          i = 0;
-                std::for_each(ret.m_d, ret.m_d + ret.pixelCount(), [this, &i, &rf, &gf, &bf](GREY8& p) {
-                    p = GREY8{.g = clampColorChanel<Pixel_t>((m_d[i].r + m_d[i].g + m_d[i].b) / 3.f)};
-                    ++i;
-                });
-                return ret;
+            auto img = greyScaleLum();
+            for (auto& p : std::span(img.m_d, img.pixelCount())) {
+                const float rand = gen();
+                if (rand < (prob / 2)) {
+                    p.g = pixel_traits<Pixel_t>::MAX;
+                } else if (rand > (1 - (prob / 2))) {
+                    p.g = 0;
+                }
             }
-
-            UNREACHABLE();
+            return img;
         }
 
-        [[nodiscard]] auto greyScaleLum()
+        [[nodiscard]] Image<Grey_t> greyScaleAvg() const
             requires(!is_grey_scale_pixel<Pixel_t>)
-
         {
-            const float rf = .2126f, gf = .7152f, bf = .0722f;
+            Image<Grey_t> ret{width(), height()};
+            if (!ret.isNull()) {
+                greyScaleAvg(ret);
+            }
+            return ret;
+        }
 
-            if constexpr (is_4_channel_pixel<Pixel_t>) {
-                Image<GREYa8> ret{m_width, m_height};
-                u32           i = 0;
-                std::for_each(ret.m_d, ret.m_d + ret.pixelCount(), [this, &i, &rf, &gf, &bf](GREYa8& p) {
-                    p = GREYa8{.g = clamp_U8B(rf * m_d[i].r + gf * m_d[i].g + bf * m_d[i].b), .a = m_d[i].a};
-                    ++i;
-                });
-                return ret;
+        // same as `greyScaleAvg()` written into `dst` of the same size, nothing is allocated.
+        Image<Grey_t>& greyScaleAvg(Image<Grey_t>& dst) const
+            requires(!is_grey_scale_pixel<Pixel_t>)
+        {
+            IMG_OP_SCOPE("greyScaleAvg", dst);
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                return hdrGreyScale({1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f}, dst);
+            } else {
+                return weightedGreyScale({21845, 21845, 21846}, dst);
             }
+        }
 
-            if constexpr (is_3_channel_pixel<Pixel_t>) {
-                Image<GREY8> ret{m_width, m_height};
-                u32          i = 0;
-                std::for_each(ret.m_d, ret.m_d + ret.pixelCount(), [this, &i, &rf, &gf, &bf](GREY8& p) {
-                    p = GREY8{.g = clamp_U8B(rf * m_d[i].r + gf * m_d[i].g + bf * m_d[i].b)};
-                    ++i;
-                });
-                return ret;
+        [[nodiscard]] Image<Grey_t> greyScaleLum() const
+            requires(!is_grey_scale_pixel<Pixel_t>)
+        {
+            Image<Grey_t> ret{width(), height()};
+            if (!ret.isNull()) {
+                greyScaleLum(ret);
             }
+            return ret;
+        }
 
-            UNREACHABLE();
+        Image<Grey_t>& greyScaleLum(Image<Grey_t>& dst) const
+            requires(!is_grey_scale_pixel<Pixel_t>)
+        {
+            IMG_OP_SCOPE("greyScaleLum", dst);
+            const float rf = .2126f, gf = .7152f, bf = .0722f;
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                return hdrGreyScale({rf, gf, bf}, dst);
+            } else {
+                // the same weights in 1 / 65536ths.
+                return weightedGreyScale({13933, 46871, 4732}, dst);
+            }
         }
 
         Image& pad(u32 topPad, u32 bottomPad, u32 leftPad, u32 rightPad, Pixel_t padColor) {
-            u32 idx_x_1 = rightPad;
-            u32 idx_y_1 = topPad;
-            u32 idx_x_2 = m_width + rightPad - 1;
-            u32 idx_y_2 = m_height + topPad - 1;
-
-            u32 oldWidth = m_width;
-
-            m_height += topPad + bottomPad;
-            m_width += rightPad + leftPad;
-            m_pixelCount = m_width * m_height;
-
-            Pixel_t* oldPixels = m_d;
-            m_d                = new Pixel_t[m_pixelCount];
-
-            for (u32 y = 0, idx = 0; y < m_height; ++y) {
-                for (u32 x = 0; x < m_width; ++x, ++idx) {
-                    if ((x >= idx_x_1) && (x <= idx_x_2) && (y >= idx_y_1) && (y <= idx_y_2)) {
-                        u32 oldIdx = oldWidth * (y - topPad) + (x - rightPad);
-                        m_d[idx]   = oldPixels[oldIdx];
-                    } else {
-                        m_d[idx] = padColor;
-                    }
+            return pad(topPad, bottomPad, leftPad, rightPad, BM_CONSTANT, padColor);
+        }
+
+        // grows the image by the given margins, filled according to `border` (`padColor` is only read by
+        // BM_CONSTANT). every row is a bulk fill of the margins around a memcpy of the source row.
+        Image& pad(u32 topPad, u32 bottomPad, u32 leftPad, u32 rightPad, BorderMode border, Pixel_t padColor = {}) {
+            IMG_OP_SCOPE("pad", *this);
+            IMG_ASSERT(border == BM_CONSTANT || m_pixelCount > 0, "only constant padding can extend an empty image");
+
+            const BorderedView view   = bordered(border, padColor);
+            const u32          width  = m_width + leftPad + rightPad;
+            const u32          height = m_height + topPad + bottomPad;
+            Pixel_t*           padded = detail::allocatePixels<Pixel_t>(std::size_t{width} * height);
+
+            parallelFor(0, height, 64, [&](u32 y0, u32 y1) {
+                for (u32 y = y0; y < y1; ++y) {
+                    u8* out = reinterpret_cast<u8*>(padded + std::size_t{y} * width);
+                    view.row(i64{y} - topPad, out, leftPad, rightPad);
                 }
-            }
+            });
 
-            delete[] oldPixels;
+            detail::freePixels(m_d);
+            m_d          = padded;
+            m_width      = width;
+            m_height     = height;
+            m_pixelCount = width * height;
 
             return *this;
         }
 
+        // this image as if it extended past its edges, see `BorderedView`. `constant` has to outlive the view.
+        BorderedView bordered(BorderMode border, const Pixel_t& constant) const {
+            resolveOrientation();
+            return {bytes(), m_width, m_height, sizeof(Pixel_t), border, reinterpret_cast<const u8*>(&constant)};
+        }
+
         Image& padBorderEqual(u32 padSize, Pixel_t padColor) {
             pad(padSize, padSize, padSize, padSize, padColor);
             return *this;
@@ -573,73 +967,491 @@ namespace img {
             IMG_ABORT("Unimplemented");
         }
 
-        Image& crop(u32 x1, u32 y1, u32 x2, u32 y2) {
-            IMG_ASSERT((x2 > x1) && (y2 > y1) && (x1 * x2 * y1 * y2 != 0),
-                       "`(x2 > x1 > 0) && (y2 > y1 > 0)` x_min = left = 1, x_max = right = width, y_min = top = 1, "
-                       "y_max = "
-                       "bottom = height.");
+        // 1-based corners: keeps columns [x1, x2) and rows [y1, y2) counting from 1, so `crop(1, 1, w + 1, h + 1)`
+        // is the whole image. the rows are compacted inside the current allocation, `shrinkToFit` moves the result
+        // into an exactly sized one.
+        Image& crop(u32 x1, u32 y1, u32 x2, u32 y2, bool shrinkToFit = false) {
+            IMG_ASSERT(x1 > 0 && y1 > 0, "1-based crop corner must be at least (1, 1), got (%u, %u)", x1, y1);
+            return cropZeroBased(x1 - 1, y1 - 1, x2 - 1, y2 - 1, shrinkToFit);
+        }
 
-            u32 old_w = m_width;
-            m_width   = x2 - x1;
-            m_height  = y2 - y1;
+        // 0-based corners: keeps columns [x0, x1) and rows [y0, y1).
+        Image& cropZeroBased(u32 x0, u32 y0, u32 x1, u32 y1, bool shrinkToFit = false) {
+            IMG_OP_SCOPE("crop", *this);
+            resolveOrientation();
+            IMG_ASSERT(x0 < x1 && x1 <= m_width && y0 < y1 && y1 <= m_height,
+                       "crop [%u, %u) x [%u, %u) is empty or outside the %ux%u image",
+                       x0,
+                       x1,
+                       y0,
+                       y1,
+                       m_width,
+                       m_height);
+
+            const u32 width  = x1 - x0;
+            const u32 height = y1 - y0;
+
+            // every destination row starts at or before its source row, moving them front to back never
+            // overwrites a row that is still to be read.
+            if (width != m_width || x0 != 0 || y0 != 0) {
+                const std::size_t rowBytes = std::size_t{width} * sizeof(Pixel_t);
+                for (u32 y = 0; y < height; ++y) {
+                    std::memmove(m_d + std::size_t{y} * width, m_d + (std::size_t{y0} + y) * m_width + x0, rowBytes);
+                }
+            }
 
-            m_pixelCount = m_width * m_height;
+            m_width      = width;
+            m_height     = height;
+            m_pixelCount = width * height;
 
-            Pixel_t* oldPixels = m_d;
+            if (shrinkToFit) {
+                Pixel_t* fitted = detail::allocatePixels<Pixel_t>(m_pixelCount);
+                std::memcpy(fitted, m_d, std::size_t{m_pixelCount} * sizeof(Pixel_t));
+                detail::freePixels(m_d);
+                m_d = fitted;
+            }
 
-            m_d = new Pixel_t[m_pixelCount];
+            return *this;
+        }
 
-            for (u32 y = y1, idx = 0; y < y2; ++y) {
-                u32 offset = (old_w * (y - 1));
-                for (u32 x = x1; x < x2; ++x, ++idx) {
-                    u32 oldIdx = offset + (x - 1);
-                    m_d[idx]   = oldPixels[oldIdx];
-                }
+        Image& blur() {
+            IMG_ABORT("Unimplemented");
+        }
+
+        // rectangular structuring element anchored at its centre, cost per pixel doesn't depend on its size.
+        Image& erode(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("erode", *this);
+            return morph<simd::MinU8>(kernelWidth, kernelHeight);
+        }
+
+        Image& dilate(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("dilate", *this);
+            return morph<simd::MaxU8>(kernelWidth, kernelHeight);
+        }
+
+        Image& morphOpen(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("morphOpen", *this);
+            erode(kernelWidth, kernelHeight);
+            return dilate(kernelWidth, kernelHeight);
+        }
+
+        Image& morphClose(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("morphClose", *this);
+            dilate(kernelWidth, kernelHeight);
+            return erode(kernelWidth, kernelHeight);
+        }
+
+        // dilate - erode.
+        Image& morphGradient(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("morphGradient", *this);
+            Image eroded{*this};
+            eroded.erode(kernelWidth, kernelHeight);
+            dilate(kernelWidth, kernelHeight);
+            simd::apply<simd::SubSatU8>(bytes(), bytes(), eroded.bytes(), byteCount());
+            return *this;
+        }
+
+        // white top-hat: image - open(image), keeps bright details smaller than the kernel.
+        Image& topHat(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("topHat", *this);
+            Image opened{*this};
+            opened.morphOpen(kernelWidth, kernelHeight);
+            simd::apply<simd::SubSatU8>(bytes(), bytes(), opened.bytes(), byteCount());
+            return *this;
+        }
+
+        // black top-hat: close(image) - image, keeps dark details smaller than the kernel.
+        Image& blackHat(u32 kernelWidth, u32 kernelHeight)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("blackHat", *this);
+            Image closed{*this};
+            closed.morphClose(kernelWidth, kernelHeight);
+            simd::apply<simd::SubSatU8>(bytes(), closed.bytes(), bytes(), byteCount());
+            return *this;
+        }
+
+        // square (2 * radius + 1)^2 window with replicated borders, each channel filtered independently. 3x3 and 5x5
+        // run sorting networks, larger windows sliding histograms whose cost per pixel doesn't depend on the radius.
+        Image& medianBlur(u32 radius)
+            requires is_color_8_bit_depth<Pixel_t>
+        {
+            IMG_OP_SCOPE("medianBlur", *this);
+            IMG_ASSERT(radius <= 127, "median radius must be at most 127");
+            if (radius == 0) {
+                return *this;
             }
 
-            delete[] oldPixels;
+            resolveOrientation();
+
+            Pixel_t* src = detail::allocateScratch<Pixel_t>(m_pixelCount);
+            std::copy(m_d, m_d + m_pixelCount, src);
+            detail::median(reinterpret_cast<const u8*>(src),
+                           bytes(),
+                           m_width,
+                           m_height,
+                           channelCountFromPixelType<Pixel_t>(),
+                           radius);
+            detail::freePixels(src);
 
             return *this;
         }
 
-        Image& blur() {
-            IMG_ABORT("Unimplemented");
+        // replaces the image with its 3x3 gradient magnitude (|gx| + |gy|, scaled so a full 0 -> 255 step reads 255)
+        // and, if `direction` is given, fills it with the gradient angle in 256 steps per turn (0 = +x, 64 = +y).
+        Image& sobel(Image* direction = nullptr)
+            requires is_1_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("sobel", *this);
+            return gradient(GK_SOBEL, direction);
+        }
+
+        // same as `sobel()` with Scharr's weights, whose angle is closer to rotation invariant.
+        Image& scharr(Image* direction = nullptr)
+            requires is_1_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("scharr", *this);
+            return gradient(GK_SCHARR, direction);
+        }
+
+        // binary edge map (0/255), thresholds are on the unscaled sobel |gx| + |gy| (0 .. 2040). the image isn't
+        // smoothed first, blur noisy input beforehand.
+        Image& canny(u16 lowThreshold, u16 highThreshold)
+            requires is_1_channel_pixel<Pixel_t>
+        {
+            IMG_OP_SCOPE("canny", *this);
+            IMG_ASSERT(lowThreshold <= highThreshold, "canny low threshold must not exceed the high threshold");
+            resolveOrientation();
+
+            Pixel_t* edges = detail::allocatePixels<Pixel_t>(m_pixelCount);
+            detail::canny(bytes(), reinterpret_cast<u8*>(edges), m_width, m_height, lowThreshold, highThreshold);
+            detail::freePixels(m_d);
+            m_d = edges;
+
+            return *this;
         }
 
     private:
-        ImageFmt getImageFormat(const fs::path& filePath) const {
+        u8* bytes() {
+            return reinterpret_cast<u8*>(m_d);
+        }
+
+        const u8* bytes() const {
+            return reinterpret_cast<const u8*>(m_d);
+        }
+
+        std::size_t byteCount() const {
+            return std::size_t{m_pixelCount} * sizeof(Pixel_t);
+        }
+
+        static constexpr u32 CHANNELS = pixel_traits<Pixel_t>::CHANNELS;
+
+        // every channel value of the image as one flat array.
+        Channel_t* channelData() {
+            return reinterpret_cast<Channel_t*>(m_d);
+        }
+
+        const Channel_t* channelData() const {
+            return reinterpret_cast<const Channel_t*>(m_d);
+        }
+
+        // logical r, g, b values rearranged into the pixel's memory order.
+        template<typename T>
+        static std::array<T, 3> inMemoryOrder(const std::array<T, 3>& rgb) {
+            std::array<T, 3> out{};
+            for (u32 k = 0; k < 3; ++k) {
+                out[pixel_traits<Pixel_t>::INDEX[k]] = rgb[k];
+            }
+            return out;
+        }
+
+        // `dst` is about to be overwritten with pixels laid out like this image's storage: takes over the stored
+        // dimensions and pending orientation, the buffer is kept. it has to look the same size as this image.
+        template<typename U>
+        void shapeLike(Image<U>& dst) const {
+            IMG_ASSERT(dst.m_d && dst.width() == width() && dst.height() == height(),
+                       "destination must be a %ux%u image, got %ux%u",
+                       width(),
+                       height(),
+                       dst.width(),
+                       dst.height());
+
+            dst.m_width       = m_width;
+            dst.m_height      = m_height;
+            dst.m_orientation = m_orientation;
+        }
+
+        // float images stay float through greyscale: r = g = b = the weighted sum, alpha kept.
+        Image& hdrGreyScale(const arr3<float>& weight, Image& dst) const
+            requires is_hdr_pixel<Pixel_t>
+        {
+            shapeLike(dst);
+            parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                const std::size_t offset = std::size_t{y0} * m_width;
+                if (&dst != this) {
+                    std::copy(m_d + offset, m_d + std::size_t{y1} * m_width, dst.m_d + offset);
+                }
+                detail::lumaPixels<CHANNELS>(
+                    dst.channelData() + offset * CHANNELS, std::size_t{y1 - y0} * m_width, weight);
+            });
+            return dst;
+        }
+
+        // integer colour -> grey of the same depth, alpha kept. `weight` is logical r, g, b in fixed point summing to
+        // 1 << 16, the weighted sum of three 16-bit channels (plus rounding) still fits 32 bits.
+        Image<Grey_t>& weightedGreyScale(const arr3<u32>& weight, Image<Grey_t>& dst) const
+            requires(!is_grey_scale_pixel<Pixel_t> && !is_hdr_pixel<Pixel_t>)
+        {
+            const arr3<u32> memoryWeight = inMemoryOrder(weight);
+
+            shapeLike(dst);
+            parallelFor(0, m_height, 64, [&](u32 y0, u32 y1) {
+                const std::size_t offset = std::size_t{y0} * m_width;
+                detail::greyChannels<CHANNELS>(channelData() + offset * CHANNELS,
+                                               dst.channelData() + offset * Image<Grey_t>::CHANNELS,
+                                               std::size_t{y1 - y0} * m_width,
+                                               memoryWeight);
+            });
+            return dst;
+        }
+
+        // element-wise `Op` over two images of the same size, a channel value per vector lane.
+        template<typename Op>
+        static Image& laneArithmetic(const Image& LHS, const Image& RHS, Image& dst) {
+            LHS.resolveOrientation();
+            RHS.resolveOrientation();
+            IMG_ASSERT(LHS.m_width == RHS.m_width && LHS.m_height == RHS.m_height,
+                       "operands must be the same size, got %ux%u and %ux%u",
+                       LHS.m_width,
+                       LHS.m_height,
+                       RHS.m_width,
+                       RHS.m_height);
+            LHS.shapeLike(dst);
+
+            parallelFor(0, LHS.m_height, 64, [&](u32 y0, u32 y1) {
+                const std::size_t offset = std::size_t{y0} * LHS.m_width * CHANNELS;
+                simd::apply<Op>(dst.channelData() + offset,
+                                LHS.channelData() + offset,
+                                RHS.channelData() + offset,
+                                std::size_t{y1 - y0} * LHS.m_width * CHANNELS);
+            });
+            return dst;
+        }
+
+        // const so reads of a const image can materialise too, see the mutable members.
+        void resolveOrientation() const {
+            if (m_orientation == OR_IDENTITY) {
+                return;
+            }
+
+            IMG_OP_SCOPE("resolveOrientation", *this);
+
+            if (!m_d) {
+                m_orientation = OR_IDENTITY;
+                return;
+            }
+
+            if (m_orientation & OR_TRANSPOSE) {
+                Pixel_t* out = detail::allocatePixels<Pixel_t>(m_pixelCount);
+                detail::orientTransposed(reinterpret_cast<const u8*>(m_d),
+                                         reinterpret_cast<u8*>(out),
+                                         m_width,
+                                         m_height,
+                                         sizeof(Pixel_t),
+                                         m_orientation);
+                detail::freePixels(m_d);
+                m_d = out;
+                std::swap(m_width, m_height);
+            } else {
+                detail::orientInPlace(reinterpret_cast<u8*>(m_d), m_width, m_height, sizeof(Pixel_t), m_orientation);
+            }
+
+            m_orientation = OR_IDENTITY;
+        }
+
+        template<typename Kernel>
+        Image& convertColor(Kernel kernel)
+            requires is_3_channel_pixel<Pixel_t>
+        {
+            constexpr auto&                INDEX = pixel_traits<Pixel_t>::INDEX;
+            constexpr detail::ChannelOrder order{INDEX[0], INDEX[1], INDEX[2]};
+            parallelFor(0, m_height, 32, [&](u32 y0, u32 y1) {
+                kernel(bytes() + std::size_t{y0} * m_width * 3, std::size_t{y1 - y0} * m_width, order);
+            });
+            return *this;
+        }
+
+        template<typename Op>
+        Image& morph(u32 kernelWidth, u32 kernelHeight) {
+            IMG_ASSERT(kernelWidth > 0 && kernelHeight > 0, "structuring element must be at least 1x1");
+            resolveOrientation();
+
+            Pixel_t* tmp = detail::allocateScratch<Pixel_t>(m_pixelCount);
+            detail::morphRect<Op>(bytes(),
+                                  reinterpret_cast<u8*>(tmp),
+                                  m_width,
+                                  m_height,
+                                  channelCountFromPixelType<Pixel_t>(),
+                                  kernelWidth,
+                                  kernelHeight);
+            detail::freePixels(tmp);
+
+            return *this;
+        }
+
+        Image& gradient(GradientKernel kernel, Image* direction)
+            requires is_1_channel_pixel<Pixel_t>
+        {
+            resolveOrientation();
+            if (direction && (direction->m_width != m_width || direction->m_height != m_height)) {
+                *direction = Image(m_width, m_height);
+            }
+            if (direction) {
+                // fully overwritten below, whatever was pending on it no longer applies.
+                direction->m_orientation = OR_IDENTITY;
+            }
+
+            Pixel_t* magnitude = detail::allocatePixels<Pixel_t>(m_pixelCount);
+            detail::gradient(bytes(),
+                             reinterpret_cast<u8*>(magnitude),
+                             direction ? direction->bytes() : nullptr,
+                             m_width,
+                             m_height,
+                             kernel);
+            detail::freePixels(m_d);
+            m_d = magnitude;
+
+            return *this;
+        }
+
+        template<typename Transform>
+        Image warped(const Transform& inverse,
+                     u32              width,
+                     u32              height,
+                     Interpolation    interpolation,
+                     BorderMode       border,
+                     Pixel_t          borderColor) const {
+            Image out{width, height};
+
+            const BorderedView source = bordered(border, borderColor);
+            detail::warp(source,
+                         channelCountFromPixelType<Pixel_t>(),
+                         out.bytes(),
+                         width,
+                         height,
+                         inverse,
+                         interpolation);
+
+            return out;
+        }
+
+        bool decodeFile(const fs::path& filePath) {
+            return decode(detail::readFile(filePath));
+        }
+
+        // probes the size first, the budget admits the pixels and the buffer stb decodes into before it does.
+        bool decode(std::span<const u8> encoded) {
+            const int c    = static_cast<int>(channelCountFromPixelType<Pixel_t>());
+            const int size = static_cast<int>(encoded.size());
+
+            int w, h, fileChannels;
+            if (!stbi_info_from_memory(encoded.data(), size, &w, &h, &fileChannels)) {
+                return false;
+            }
+
+            const u64 bytes = u64{static_cast<u32>(w)} * static_cast<u32>(h) * sizeof(Pixel_t);
+            if (!detail::tryChargePixels(2 * bytes, 1, true)) {
+                return false;
+            }
+
+            if constexpr (is_hdr_pixel<Pixel_t>) {
+                // 8-bit files come back in linear light too, stb undoes their gamma.
+                float* d = stbi_loadf_from_memory(encoded.data(), size, &w, &h, &fileChannels, c);
+                return adoptDecoded(d, w, h, bytes);
+            } else if constexpr (is_color_16_bit_depth<Pixel_t>) {
+                // 8-bit files are widened, v * 257.
+                u16* d = stbi_load_16_from_memory(encoded.data(), size, &w, &h, &fileChannels, c);
+                return adoptDecoded(d, w, h, bytes);
+            } else {
+                u8* d = stbi_load_from_memory(encoded.data(), size, &w, &h, &fileChannels, c);
+                return adoptDecoded(d, w, h, bytes);
+            }
+        }
+
+        // copies an stb decode result (bytes, 16-bit samples or floats) into a fresh pixel buffer and frees it.
+        // `decode()` charged `2 * bytes` for the two, what stb held is released once it is freed.
+        template<typename Channel>
+        bool adoptDecoded(Channel* d, int w, int h, u64 bytes) {
+            if (!d) {
+                detail::releasePixels(2 * bytes, 1);
+                return false;
+            }
+
+            const u32 width  = static_cast<u32>(w);
+            const u32 height = static_cast<u32>(h);
+
+            IMG_DEBUG_ASSERT((width * height) <= LIB_IMG_MAX_SIZE,
+                             "Image pixel count exceeded `LIB_IMG_MAX_SIZE`: %u, image pixel count: %d"
+                             "are you sure this file is valid?",
+                             LIB_IMG_MAX_SIZE,
+                             width * height);
+
+            m_d           = detail::newPixelBlock<Pixel_t>(bytes, 1);
+            m_width       = width;
+            m_height      = height;
+            m_pixelCount  = width * height;
+            m_orientation = OR_IDENTITY;
+
+            std::memcpy(m_d, d, byteCount());
+            stbi_image_free(d);
+            detail::releasePixels(bytes, 0);
+
+            return true;
+        }
+
+        // what a refused allocation leaves behind.
+        void becomeNull() {
+            m_width       = 0;
+            m_height      = 0;
+            m_pixelCount  = 0;
+            m_orientation = OR_IDENTITY;
+        }
+
+        static ImageFmt getImageFormat(const fs::path& filePath) {
             if (!filePath.has_extension()) {
                 IMG_ABORT("Image extention is missing, the path is invalid: `%s`", filePath.c_str());
             }
 
-            std::string ext = filePath.extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), [](const unsigned char& c) { return std::toupper(c); });
-            return imageTypeMap.at(ext);
+            const fs::path ext = filePath.extension();
+            return imageFormatFromExtension(ext.native());
         }
 
     private:
-        Pixel* m_d;
+        // mutable so a const image with a pending orientation can still be materialised when it's read.
+        mutable Pixel* m_d;
 
-        u32 m_width, m_height, m_pixelCount;
+        mutable u32 m_width, m_height, m_pixelCount;
 
-        const std::unordered_map<std::string, ImageFmt> imageTypeMap{
-            {".JPEG", IF_JPEG},
-            { ".JPG",  IF_JPG},
-            { ".PNG",  IF_PNG},
-            { ".BMP",  IF_BMP},
-            { ".HDR",  IF_HDR}
-        };
-
-        // const std::unordered_map<PixelFmt, std::string> PixelFormatMap{
-        //     { PF_GREY8,  "GREY8"},
-        //     {PF_GREYa8, "GREYa8"},
-        //     {  PF_RGB8,   "RGB8"},
-        //     { PF_RGBa8,  "RGBa8"},
-        //     {  PF_BGR8,   "BGR8"},
-        //     { PF_BGRa8,  "BGRa8"},
-        // };
+        mutable Orientation m_orientation = OR_IDENTITY;
     };
 
+    // an image is its pixel pointer, dimensions and pending orientation, nothing per instance is heap allocated
+    // besides the pixels.
+    static_assert(sizeof(Image<RGB8>) <= sizeof(RGB8*) + 4 * sizeof(u32));
+    static_assert(std::is_nothrow_move_constructible_v<Image<RGB8>> && std::is_nothrow_move_assignable_v<Image<RGB8>>);
+
 } // namespace img
 
 #endif // LIB_IMG_IMAGE_H
\ No newline at end of file
@@ -0,0 +1,283 @@
+#ifndef LIB_IMG_LUT_H
+#define LIB_IMG_LUT_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "common.hpp"
+#include "img_assert.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // any u8 -> u8 point operation, evaluated once per value instead of once per channel per pixel.
+    using Lut = std::array<u8, 256>;
+
+    namespace detail {
+
+        template<typename Fn>
+        Lut tabulate(Fn fn) {
+            Lut t;
+            for (u32 v = 0; v < 256; ++v) {
+                t[v] = static_cast<u8>(std::clamp(std::lround(fn(static_cast<float>(v))), 0l, 255l));
+            }
+            return t;
+        }
+
+    } // namespace detail
+
+    inline Lut identityLut() {
+        Lut t;
+        for (u32 v = 0; v < 256; ++v) {
+            t[v] = static_cast<u8>(v);
+        }
+        return t;
+    }
+
+    inline Lut invertLut() {
+        Lut t;
+        for (u32 v = 0; v < 256; ++v) {
+            t[v] = static_cast<u8>(255 - v);
+        }
+        return t;
+    }
+
+    // 255 * (v / 255)^(1 / gamma), gamma above 1 brightens the midtones.
+    inline Lut gammaLut(float gamma) {
+        IMG_ASSERT(gamma > 0.0f, "gamma must be positive, got %f", static_cast<double>(gamma));
+        return detail::tabulate([g = 1.0f / gamma](float v) { return 255.0f * std::pow(v / 255.0f, g); });
+    }
+
+    // (v - 128) * contrast + 128 + brightness, brightness in 8-bit steps.
+    inline Lut brightnessContrastLut(float brightness, float contrast) {
+        return detail::tabulate([=](float v) { return (v - 128.0f) * contrast + 128.0f + brightness; });
+    }
+
+    // v * gain, what `colorMask` applies per channel.
+    inline Lut gainLut(float gain) {
+        return detail::tabulate([gain](float v) { return v * gain; });
+    }
+
+    // maps [inBlack, inWhite] onto [outBlack, outWhite] with a midtone gamma, values outside the input range clip.
+    inline Lut levelsLut(u8 inBlack, u8 inWhite, float gamma = 1.0f, u8 outBlack = 0, u8 outWhite = 255) {
+        IMG_ASSERT(inBlack < inWhite, "levels input range is empty: [%u, %u]", inBlack, inWhite);
+        IMG_ASSERT(gamma > 0.0f, "gamma must be positive, got %f", static_cast<double>(gamma));
+        return detail::tabulate([=, g = 1.0f / gamma](float v) {
+            const float t = std::clamp((v - inBlack) / static_cast<float>(inWhite - inBlack), 0.0f, 1.0f);
+            return outBlack + (outWhite - outBlack) * std::pow(t, g);
+        });
+    }
+
+    // monotone cubic through the (input, output) control points (Fritsch-Carlson), flat past the first and last
+    // ones. points don't need to be sorted, duplicated inputs keep the last output.
+    inline Lut curvesLut(std::span<const arr2<u8>> points) {
+        IMG_ASSERT(!points.empty(), "curves need at least one control point");
+
+        std::vector<arr2<u8>> sorted(points.begin(), points.end());
+        std::stable_sort(
+            sorted.begin(), sorted.end(), [](const arr2<u8>& a, const arr2<u8>& b) { return a[0] < b[0]; });
+
+        std::vector<arr2<u8>> p;
+        for (const arr2<u8>& q : sorted) {
+            if (!p.empty() && p.back()[0] == q[0]) {
+                p.back() = q;
+            } else {
+                p.push_back(q);
+            }
+        }
+
+        const std::size_t n = p.size();
+        if (n == 1) {
+            return detail::tabulate([y = p[0][1]](float) { return static_cast<float>(y); });
+        }
+
+        std::vector<float> slope(n - 1), tangent(n);
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            slope[i] = static_cast<float>(p[i + 1][1] - p[i][1]) / static_cast<float>(p[i + 1][0] - p[i][0]);
+        }
+        tangent[0]     = slope[0];
+        tangent[n - 1] = slope[n - 2];
+        for (std::size_t i = 1; i + 1 < n; ++i) {
+            tangent[i] = slope[i - 1] * slope[i] <= 0.0f ? 0.0f : (slope[i - 1] + slope[i]) / 2.0f;
+        }
+        // limit the tangents so each segment stays monotone.
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            if (slope[i] == 0.0f) {
+                tangent[i] = tangent[i + 1] = 0.0f;
+                continue;
+            }
+            const float a = tangent[i] / slope[i], b = tangent[i + 1] / slope[i];
+            const float s = a * a + b * b;
+            if (s > 9.0f) {
+                const float k  = 3.0f / std::sqrt(s);
+                tangent[i]     = k * a * slope[i];
+                tangent[i + 1] = k * b * slope[i];
+            }
+        }
+
+        std::size_t seg = 0;
+        return detail::tabulate([&](float v) {
+            if (v <= p[0][0]) {
+                return static_cast<float>(p[0][1]);
+            }
+            if (v >= p[n - 1][0]) {
+                return static_cast<float>(p[n - 1][1]);
+            }
+            while (v > p[seg + 1][0]) {
+                ++seg;
+            }
+
+            const float h = static_cast<float>(p[seg + 1][0] - p[seg][0]);
+            const float t = (v - p[seg][0]) / h, t2 = t * t, t3 = t2 * t;
+            return (2 * t3 - 3 * t2 + 1) * p[seg][1] + (t3 - 2 * t2 + t) * h * tangent[seg]
+                 + (-2 * t3 + 3 * t2) * p[seg + 1][1] + (t3 - t2) * h * tangent[seg + 1];
+        });
+    }
+
+    // a single table applying `first` then each of `rest` in order.
+    template<typename... Luts>
+    Lut composeLuts(const Lut& first, const Luts&... rest) {
+        Lut t = first;
+        (
+            [&](const Lut& next) {
+                for (u8& v : t) {
+                    v = next[v];
+                }
+            }(rest),
+            ...);
+        return t;
+    }
+
+} // namespace img
+
+namespace img::detail {
+
+#if LIB_IMG_AVX2
+    // 256 entry lookup with vpshufb: the table is split in 16 rows of 16, on step k every byte has k * 16
+    // subtracted and a saturating add of 0x70 pushes anything outside [0, 16) to the high bit, which vpshufb
+    // turns into 0, so exactly one row contributes each output byte. the 128-bit version of this loses to a
+    // plain table walk, at 32 bytes per step it comes out ahead.
+    struct LutRows {
+        __m256i row[16];
+
+        explicit LutRows(const Lut& lut) {
+            for (u32 k = 0; k < 16; ++k) {
+                const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.data() + k * 16));
+                row[k]          = _mm256_broadcastsi128_si256(r);
+            }
+        }
+
+        __m256i lookup(__m256i v) const {
+            const __m256i step = _mm256_set1_epi8(16);
+            const __m256i bias = _mm256_set1_epi8(0x70);
+            __m256i       out  = _mm256_shuffle_epi8(row[0], _mm256_adds_epu8(v, bias));
+            for (u32 k = 1; k < 16; ++k) {
+                v   = _mm256_sub_epi8(v, step);
+                out = _mm256_or_si256(out, _mm256_shuffle_epi8(row[k], _mm256_adds_epu8(v, bias)));
+            }
+            return out;
+        }
+    };
+#endif
+
+    // colour bytes of `pixels` pixels of `C` bytes through `lut`, alpha (the last byte of 2 and 4 byte pixels) is
+    // left alone, which the vector path does with a fixed blend pattern since the pixel size divides 32.
+    template<u32 C>
+    void lutBytes(u8* px, std::size_t pixels, const Lut& lut) {
+        constexpr bool HAS_ALPHA = C == 2 || C == 4;
+
+        const std::size_t n = pixels * C;
+        std::size_t       i = 0;
+#if LIB_IMG_AVX2
+        alignas(32) u8 keepBytes[32];
+        for (u32 b = 0; b < 32; ++b) {
+            keepBytes[b] = HAS_ALPHA && b % C == C - 1 ? 0xFF : 0x00;
+        }
+        const __m256i keep = _mm256_load_si256(reinterpret_cast<const __m256i*>(keepBytes));
+        const LutRows rows(lut);
+        for (; i + 32 <= n; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i), _mm256_blendv_epi8(rows.lookup(v), v, keep));
+        }
+#endif
+        if constexpr (HAS_ALPHA) {
+            for (; i < n; i += C) {
+                for (u32 c = 0; c + 1 < C; ++c) {
+                    px[i + c] = lut[px[i + c]];
+                }
+            }
+        } else {
+            for (; i < n; ++i) {
+                px[i] = lut[px[i]];
+            }
+        }
+    }
+
+    inline void lutBytes(u8* px, std::size_t pixels, u32 channels, const Lut& lut) {
+        switch (channels) {
+            case 1: lutBytes<1>(px, pixels, lut); break;
+            case 2: lutBytes<2>(px, pixels, lut); break;
+            case 3: lutBytes<3>(px, pixels, lut); break;
+            case 4: lutBytes<4>(px, pixels, lut); break;
+            default: IMG_ABORT("unsupported channel count: %u", channels);
+        }
+    }
+
+    // one table per colour byte of 3 and 4 byte pixels, in memory order, alpha is left alone. vpshufb picks from one
+    // table per lane, not per byte, so 3 byte pixels gather instead: the tables are laid end to end and every byte
+    // is offset into its channel's, 48 bytes (16 pixels) per step, about twice as fast as the scalar walk. 4 byte pixels
+    // would gather a wasted alpha lane per pixel and don't beat it, they stay scalar.
+    template<u32 C>
+    void lutPixels(u8* px, std::size_t pixels, const std::array<const Lut*, 3>& luts) {
+        const Lut &l0 = *luts[0], &l1 = *luts[1], &l2 = *luts[2];
+
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        if constexpr (C == 3) {
+            alignas(32) i32 table[3 * 256];
+            for (u32 v = 0; v < 256; ++v) {
+                table[v]       = l0[v];
+                table[256 + v] = l1[v];
+                table[512 + v] = l2[v];
+            }
+
+            // byte b of a step belongs to channel b % 3, its index is offset by 256 per channel.
+            __m256i offset[6];
+            for (u32 k = 0; k < 6; ++k) {
+                alignas(32) i32 o[8];
+                for (u32 b = 0; b < 8; ++b) {
+                    o[b] = static_cast<i32>((k * 8 + b) % 3 * 256);
+                }
+                offset[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(o));
+            }
+
+            auto gather = [&](const u8* p, u32 k) {
+                const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+                return _mm256_i32gather_epi32(table, _mm256_add_epi32(v, offset[k]), 4);
+            };
+            for (; i + 16 <= pixels; i += 16, px += 48) {
+                for (u32 k = 0; k < 6; k += 2) {
+                    // packus interleaves the 128-bit lanes, put them back in order before the final narrowing.
+                    const __m256i w = _mm256_permute4x64_epi64(
+                        _mm256_packus_epi32(gather(px + k * 8, k), gather(px + k * 8 + 8, k + 1)), 0xD8);
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(px + k * 8),
+                        _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+                }
+            }
+        }
+#endif
+        for (; i < pixels; ++i, px += C) {
+            px[0] = l0[px[0]];
+            px[1] = l1[px[1]];
+            px[2] = l2[px[2]];
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_LUT_H
@@ -0,0 +1,302 @@
+#ifndef LIB_IMG_MEDIAN_H
+#define LIB_IMG_MEDIAN_H
+
+#include <algorithm>
+#include <vector>
+
+#include "border.hpp"
+#include "common.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img::detail {
+
+    // median filters on interleaved 8-bit channels over a (2r + 1)^2 window, borders replicate the edge pixels.
+
+    inline void sortPair(u8& a, u8& b) {
+        const u8 lo = std::min(a, b);
+        b           = std::max(a, b);
+        a           = lo;
+    }
+
+#if LIB_IMG_SSE2
+    inline void sortPair(__m128i& a, __m128i& b) {
+        const __m128i lo = _mm_min_epu8(a, b);
+        b                = _mm_max_epu8(a, b);
+        a                = lo;
+    }
+#endif
+
+#if LIB_IMG_AVX2
+    inline void sortPair(__m256i& a, __m256i& b) {
+        const __m256i lo = _mm256_min_epu8(a, b);
+        b                = _mm256_max_epu8(a, b);
+        a                = lo;
+    }
+#endif
+
+    // Paeth/Devillard selection networks, only the comparators that can move the median are kept.
+    template<typename V>
+    V median9(V* p) {
+        // clang-format off
+        sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+        sortPair(p[0], p[1]); sortPair(p[3], p[4]); sortPair(p[6], p[7]);
+        sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+        sortPair(p[0], p[3]); sortPair(p[5], p[8]); sortPair(p[4], p[7]);
+        sortPair(p[3], p[6]); sortPair(p[1], p[4]); sortPair(p[2], p[5]);
+        sortPair(p[4], p[7]); sortPair(p[4], p[2]); sortPair(p[6], p[4]);
+        sortPair(p[4], p[2]);
+        // clang-format on
+        return p[4];
+    }
+
+    template<typename V>
+    V median25(V* p) {
+        // clang-format off
+        sortPair(p[0],  p[1]);  sortPair(p[3],  p[4]);  sortPair(p[2],  p[4]);  sortPair(p[2],  p[3]);
+        sortPair(p[6],  p[7]);  sortPair(p[5],  p[7]);  sortPair(p[5],  p[6]);  sortPair(p[9],  p[10]);
+        sortPair(p[8],  p[10]); sortPair(p[8],  p[9]);  sortPair(p[12], p[13]); sortPair(p[11], p[13]);
+        sortPair(p[11], p[12]); sortPair(p[15], p[16]); sortPair(p[14], p[16]); sortPair(p[14], p[15]);
+        sortPair(p[18], p[19]); sortPair(p[17], p[19]); sortPair(p[17], p[18]); sortPair(p[21], p[22]);
+        sortPair(p[20], p[22]); sortPair(p[20], p[21]); sortPair(p[23], p[24]); sortPair(p[2],  p[5]);
+        sortPair(p[3],  p[6]);  sortPair(p[0],  p[6]);  sortPair(p[0],  p[3]);  sortPair(p[4],  p[7]);
+        sortPair(p[1],  p[7]);  sortPair(p[1],  p[4]);  sortPair(p[11], p[14]); sortPair(p[8],  p[14]);
+        sortPair(p[8],  p[11]); sortPair(p[12], p[15]); sortPair(p[9],  p[15]); sortPair(p[9],  p[12]);
+        sortPair(p[13], p[16]); sortPair(p[10], p[16]); sortPair(p[10], p[13]); sortPair(p[20], p[23]);
+        sortPair(p[17], p[23]); sortPair(p[17], p[20]); sortPair(p[21], p[24]); sortPair(p[18], p[24]);
+        sortPair(p[18], p[21]); sortPair(p[19], p[22]); sortPair(p[8],  p[17]); sortPair(p[9],  p[18]);
+        sortPair(p[0],  p[18]); sortPair(p[0],  p[9]);  sortPair(p[10], p[19]); sortPair(p[1],  p[19]);
+        sortPair(p[1],  p[10]); sortPair(p[11], p[20]); sortPair(p[2],  p[20]); sortPair(p[2],  p[11]);
+        sortPair(p[12], p[21]); sortPair(p[3],  p[21]); sortPair(p[3],  p[12]); sortPair(p[13], p[22]);
+        sortPair(p[4],  p[22]); sortPair(p[4],  p[13]); sortPair(p[14], p[23]); sortPair(p[5],  p[23]);
+        sortPair(p[5],  p[14]); sortPair(p[15], p[24]); sortPair(p[6],  p[24]); sortPair(p[6],  p[15]);
+        sortPair(p[7],  p[16]); sortPair(p[7],  p[19]); sortPair(p[13], p[21]); sortPair(p[15], p[23]);
+        sortPair(p[7],  p[13]); sortPair(p[7],  p[15]); sortPair(p[1],  p[9]);  sortPair(p[3],  p[11]);
+        sortPair(p[5],  p[17]); sortPair(p[11], p[17]); sortPair(p[9],  p[17]); sortPair(p[4],  p[10]);
+        sortPair(p[6],  p[12]); sortPair(p[7],  p[14]); sortPair(p[4],  p[6]);  sortPair(p[4],  p[7]);
+        sortPair(p[12], p[14]); sortPair(p[10], p[14]); sortPair(p[6],  p[7]);  sortPair(p[10], p[12]);
+        sortPair(p[6],  p[10]); sortPair(p[6],  p[17]); sortPair(p[12], p[17]); sortPair(p[7],  p[17]);
+        sortPair(p[7],  p[10]); sortPair(p[12], p[18]); sortPair(p[7],  p[12]); sortPair(p[10], p[18]);
+        sortPair(p[12], p[20]); sortPair(p[10], p[20]); sortPair(p[10], p[12]);
+        // clang-format on
+        return p[12];
+    }
+
+    template<u32 R, typename V>
+    V medianNetwork(V* p) {
+        if constexpr (R == 1) {
+            return median9(p);
+        } else {
+            return median25(p);
+        }
+    }
+
+    // copies source row `y` (clamped) with `r` replicated pixels on each side.
+    inline void padRowReplicate(const u8* src, u8* dst, u32 width, u32 height, u32 channels, i64 y, u32 r) {
+        const std::size_t rowLen = std::size_t{width} * channels;
+        const u8*         row    = src + std::clamp<i64>(y, 0, i64{height} - 1) * rowLen;
+        std::copy_n(row, rowLen, dst + std::size_t{r} * channels);
+        extendRow(dst, width, channels, r, r, BM_REPLICATE, nullptr);
+    }
+
+    // the median of every channel value in [begin, end) of an output row, 16/32 at once. tap (dx, dy) of value `i`
+    // is `rows[dy][i - shift + dx * channels]`: padded rows have `shift` 0, source rows read in place `R` pixels.
+    template<u32 R>
+    void medianSpan(const u8* const* rows, std::size_t shift, u32 channels, u8* out, std::size_t begin,
+                    std::size_t end) {
+        constexpr u32 K = 2 * R + 1;
+
+        std::size_t i = begin;
+#if LIB_IMG_AVX2
+        for (; i + 32 <= end; i += 32) {
+            __m256i p[K * K];
+            for (u32 dy = 0; dy < K; ++dy) {
+                for (u32 dx = 0; dx < K; ++dx) {
+                    p[dy * K + dx] = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(rows[dy] + (i - shift) + dx * channels));
+                }
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), medianNetwork<R>(p));
+        }
+#endif
+#if LIB_IMG_SSE2
+        for (; i + 16 <= end; i += 16) {
+            __m128i p[K * K];
+            for (u32 dy = 0; dy < K; ++dy) {
+                for (u32 dx = 0; dx < K; ++dx) {
+                    p[dy * K + dx]
+                        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[dy] + (i - shift) + dx * channels));
+                }
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), medianNetwork<R>(p));
+        }
+#endif
+        for (; i < end; ++i) {
+            u8 p[K * K];
+            for (u32 dy = 0; dy < K; ++dy) {
+                for (u32 dx = 0; dx < K; ++dx) {
+                    p[dy * K + dx] = rows[dy][(i - shift) + dx * channels];
+                }
+            }
+            out[i] = medianNetwork<R>(p);
+        }
+    }
+
+    // 3x3 and 5x5: a sorting network evaluated on 16/32 channel values at once. rows whose window stays inside the
+    // image read the source in place and clamp only the `R` columns at either end, the `R` rows at the top and
+    // bottom go through replicate padded copies.
+    template<u32 R>
+    void medianSmall(const u8* src, u8* dst, u32 width, u32 height, u32 channels) {
+        constexpr u32     K      = 2 * R + 1;
+        const std::size_t rowLen = std::size_t{width} * channels;
+        const std::size_t padLen = (std::size_t{width} + 2 * R) * channels;
+
+        const auto [rowBegin, rowEnd] = BorderedView::interior(height, R, R);
+        const auto [colBegin, colEnd] = BorderedView::interior(width, R, R);
+
+        auto clampedPixel = [&](u32 x, u32 y, u8* out) {
+            for (u32 c = 0; c < channels; ++c) {
+                u8 p[K * K];
+                for (u32 dy = 0; dy < K; ++dy) {
+                    const std::size_t row = std::size_t{y + dy - R} * rowLen;
+                    for (u32 dx = 0; dx < K; ++dx) {
+                        const i64 sx   = std::clamp<i64>(i64{x} + dx - R, 0, i64{width} - 1);
+                        p[dy * K + dx] = src[row + static_cast<std::size_t>(sx) * channels + c];
+                    }
+                }
+                out[std::size_t{x} * channels + c] = medianNetwork<R>(p);
+            }
+        };
+
+        parallelFor(0, height, 16, [&](u32 y0, u32 y1) {
+            std::vector<u8> padded;
+            const u8*       rows[K];
+
+            for (u32 y = y0; y < y1; ++y) {
+                u8* out = dst + y * rowLen;
+
+                if (y >= rowBegin && y < rowEnd) {
+                    for (u32 dy = 0; dy < K; ++dy) {
+                        rows[dy] = src + std::size_t{y + dy - R} * rowLen;
+                    }
+                    medianSpan<R>(rows, R * channels, channels, out, colBegin * channels, colEnd * channels);
+                    for (u32 x = 0; x < colBegin; ++x) {
+                        clampedPixel(x, y, out);
+                    }
+                    for (u32 x = colEnd; x < width; ++x) {
+                        clampedPixel(x, y, out);
+                    }
+                    continue;
+                }
+
+                padded.resize(K * padLen);
+                for (u32 dy = 0; dy < K; ++dy) {
+                    padRowReplicate(src, padded.data() + dy * padLen, width, height, channels, i64{y} + dy - R, R);
+                    rows[dy] = padded.data() + dy * padLen;
+                }
+                medianSpan<R>(rows, 0, channels, out, 0, rowLen);
+            }
+        });
+    }
+
+    // Perreault-Hebert: one histogram per column slides down the band and the window histogram slides right by
+    // adding one column and removing another, so the cost per pixel doesn't grow with the radius. only the 16 bin
+    // coarse level slides every pixel, a 16 bin slice of the fine level is brought up to date when the median
+    // falls into it, by replaying the missed slides or rebuilding it from the columns, whichever is cheaper.
+    inline void medianHistogram(const u8* src, u8* dst, u32 width, u32 height, u32 channels, u32 r) {
+        constexpr u32     COARSE = 16, FINE = 256, BINS = COARSE + FINE;
+        const std::size_t rowLen = std::size_t{width} * channels;
+        const u32         k      = 2 * r + 1;
+        const u32         half   = (k * k) / 2;
+
+        auto clampX = [width](i64 x) { return static_cast<u32>(std::clamp<i64>(x, 0, i64{width} - 1)); };
+        auto clampY = [height](i64 y) { return static_cast<u32>(std::clamp<i64>(y, 0, i64{height} - 1)); };
+
+        parallelFor(0, height, 32, [&](u32 y0, u32 y1) {
+            // per column: 16 coarse bins followed by 256 fine bins.
+            std::vector<u16> cols(std::size_t{width} * BINS);
+            u16              coarse[COARSE];
+            u16              fine[FINE];
+            i64              synced[COARSE];
+
+            auto column = [&](i64 x) { return &cols[std::size_t{clampX(x)} * BINS]; };
+
+            for (u32 c = 0; c < channels; ++c) {
+                auto bump = [&](u32 x, u32 y, i32 delta) {
+                    const u8 v   = src[y * rowLen + std::size_t{x} * channels + c];
+                    u16*     col = &cols[std::size_t{x} * BINS];
+                    col[v >> 4] += static_cast<u16>(delta);
+                    col[COARSE + v] += static_cast<u16>(delta);
+                };
+
+                std::fill(cols.begin(), cols.end(), 0);
+                for (i64 dy = -i64{r}; dy <= i64{r}; ++dy) {
+                    for (u32 x = 0; x < width; ++x) {
+                        bump(x, clampY(y0 + dy), 1);
+                    }
+                }
+
+                for (u32 y = y0; y < y1; ++y) {
+                    if (y > y0) {
+                        for (u32 x = 0; x < width; ++x) {
+                            bump(x, clampY(i64{y} - r - 1), -1);
+                            bump(x, clampY(i64{y} + r), 1);
+                        }
+                    }
+
+                    std::fill(std::begin(coarse), std::end(coarse), 0);
+                    for (i64 dx = -i64{r}; dx <= i64{r}; ++dx) {
+                        simd::addU16(coarse, column(dx), COARSE);
+                    }
+                    std::fill(std::begin(synced), std::end(synced), -i64{k} - 1);
+
+                    u8* out = dst + y * rowLen + c;
+                    for (u32 x = 0; x < width; ++x) {
+                        if (x > 0) {
+                            simd::slideU16(coarse, column(i64{x} + r), column(i64{x} - r - 1), COARSE);
+                        }
+
+                        u32 acc = 0, bucket = 0;
+                        while (acc + coarse[bucket] <= half) {
+                            acc += coarse[bucket++];
+                        }
+
+                        u16*              slice  = fine + bucket * 16;
+                        const std::size_t offset = COARSE + bucket * 16;
+                        if (x - synced[bucket] >= k) {
+                            std::fill_n(slice, 16, 0);
+                            for (i64 dx = -i64{r}; dx <= i64{r}; ++dx) {
+                                simd::addU16(slice, column(x + dx) + offset, 16);
+                            }
+                        } else {
+                            for (i64 s = synced[bucket] + 1; s <= x; ++s) {
+                                simd::slideU16(slice, column(s + r) + offset, column(s - r - 1) + offset, 16);
+                            }
+                        }
+                        synced[bucket] = x;
+
+                        u32 bin = 0;
+                        while (acc + slice[bin] <= half) {
+                            acc += slice[bin++];
+                        }
+
+                        out[std::size_t{x} * channels] = static_cast<u8>(bucket * 16 + bin);
+                    }
+                }
+            }
+        });
+    }
+
+    inline void median(const u8* src, u8* dst, u32 width, u32 height, u32 channels, u32 radius) {
+        switch (radius) {
+            case 0: std::copy_n(src, std::size_t{width} * height * channels, dst); break;
+            case 1: medianSmall<1>(src, dst, width, height, channels); break;
+            case 2: medianSmall<2>(src, dst, width, height, channels); break;
+            default: medianHistogram(src, dst, width, height, channels, radius); break;
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_MEDIAN_H
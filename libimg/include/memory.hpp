@@ -0,0 +1,294 @@
+#ifndef LIB_IMG_MEMORY_H
+#define LIB_IMG_MEMORY_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "common.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+
+// ops tracked by `memoryStatsByOp()`, allocations of ops past the limit are summed up under "other".
+#ifndef LIB_IMG_MEMORY_OPS
+    #define LIB_IMG_MEMORY_OPS 64
+#endif
+
+namespace img {
+
+    // the budget admits images, see `setMemoryBudget()` for what it checks.
+    enum BudgetPolicy : u8 {
+        MB_FAIL  = 0, // loading or creating an image over the budget gives a null image
+        MB_BLOCK = 1, // loading or creating an image over the budget waits until enough pixels are released
+    };
+
+    struct MemoryStats {
+        u64          liveImages;  // pixel buffers held by images and gif frame sequences
+        u64          liveBytes;   // pixel bytes they hold, plus the image sized scratch of ops still running
+        u64          peakBytes;   // highest `liveBytes` since startup or the last `resetPeakMemory()`
+        u64          allocations; // pixel buffers allocated so far
+        u64          budget;      // 0 when unlimited
+        BudgetPolicy policy;
+    };
+
+    struct OpMemoryStats {
+        const char* op; // "image" for buffers allocated outside any op (constructors, copies)
+        u64         allocations;
+        u64         bytes; // allocated in total, not what is still live
+    };
+
+    namespace detail {
+
+        struct MemoryOpSlot {
+            std::atomic<const char*> op{nullptr};
+            std::atomic<u64>         allocations{0};
+            std::atomic<u64>         bytes{0};
+        };
+
+        // leaked on purpose, images owned by other statics are still released while statics are destroyed at exit.
+        struct MemoryCounters {
+            std::atomic<u64> liveImages{0};
+            std::atomic<u64> liveBytes{0};
+            std::atomic<u64> peakBytes{0};
+            std::atomic<u64> allocations{0};
+            std::atomic<u64> budget{0};
+            std::atomic<u8>  policy{MB_FAIL};
+
+            // blocked allocations wait on `released`, a release only takes the mutex when someone is waiting.
+            std::atomic<u32>        waiters{0};
+            std::mutex              mutex;
+            std::condition_variable released;
+            u64                     generation = 0; // bumped under `mutex` by every budget change
+
+            std::array<MemoryOpSlot, LIB_IMG_MEMORY_OPS> ops;
+
+            MemoryCounters() {
+                ops.back().op.store("other", std::memory_order_relaxed);
+            }
+
+            static MemoryCounters& get() {
+                static auto* counters = new MemoryCounters;
+                return *counters;
+            }
+        };
+
+        inline const char*& memoryOpTag() {
+            thread_local const char* tag = nullptr;
+            return tag;
+        }
+
+        // accounts this thread's pixel allocations to `op` until the scope closes. the outermost op keeps the tag:
+        // the copy `topHat()` makes and the scratch of the erode it runs are all charged to the top-hat.
+        class MemoryOpScope {
+        public:
+            explicit MemoryOpScope(const char* op) : m_owner(!memoryOpTag()) {
+                if (m_owner) {
+                    memoryOpTag() = op;
+                }
+            }
+
+            MemoryOpScope(const MemoryOpScope&)            = delete;
+            MemoryOpScope& operator=(const MemoryOpScope&) = delete;
+
+            ~MemoryOpScope() {
+                if (m_owner) {
+                    memoryOpTag() = nullptr;
+                }
+            }
+
+        private:
+            bool m_owner;
+        };
+
+        // names are compared by pointer first and by content when literals of one name differ between translation
+        // units. a free slot is claimed with a CAS, so a name never ends up in two slots.
+        inline MemoryOpSlot& memoryOpSlot(const char* op) {
+            auto& ops = MemoryCounters::get().ops;
+            for (std::size_t i = 0; i + 1 < ops.size(); ++i) {
+                const char* name = ops[i].op.load(std::memory_order_acquire);
+                if (!name && ops[i].op.compare_exchange_strong(name, op, std::memory_order_acq_rel)) {
+                    return ops[i];
+                }
+                if (name == op || std::strcmp(name, op) == 0) {
+                    return ops[i];
+                }
+            }
+            return ops.back();
+        }
+
+        // accounts `bytes` about to be allocated, `images` is 1 for a buffer an image keeps and 0 for scratch.
+        // with `admit` the budget applies: false when they don't fit under MB_FAIL, or exceed the whole budget on
+        // their own under MB_BLOCK, which otherwise waits for releases. without it they are only counted, an op
+        // that failed or waited for its scratch halfway would leave its image half processed, or deadlock against
+        // every other op holding its input while it waits.
+        inline bool tryChargePixels(u64 bytes, u64 images, bool admit) {
+            MemoryCounters& c = MemoryCounters::get();
+
+            u64 live = c.liveBytes.load(std::memory_order_relaxed);
+            for (;;) {
+                const u64  budget = c.budget.load(std::memory_order_relaxed);
+                const bool fail   = c.policy.load(std::memory_order_relaxed) == MB_FAIL;
+                if (admit && budget && live + bytes > budget) {
+                    if (fail || bytes > budget) {
+                        return false;
+                    }
+
+                    std::unique_lock lock{c.mutex};
+                    const u64        generation = c.generation;
+                    ++c.waiters;
+                    c.released.wait(lock, [&] {
+                        return c.generation != generation || c.liveBytes.load() + bytes <= budget;
+                    });
+                    --c.waiters;
+                    live = c.liveBytes.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (c.liveBytes.compare_exchange_weak(live, live + bytes, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+
+            u64 peak = c.peakBytes.load(std::memory_order_relaxed);
+            while (live + bytes > peak &&
+                   !c.peakBytes.compare_exchange_weak(peak, live + bytes, std::memory_order_relaxed)) {
+            }
+
+            c.liveImages.fetch_add(images, std::memory_order_relaxed);
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+            const char*   op   = memoryOpTag();
+            MemoryOpSlot& slot = memoryOpSlot(op ? op : "image");
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        inline void releasePixels(u64 bytes, u64 images) {
+            MemoryCounters& c = MemoryCounters::get();
+            c.liveImages.fetch_sub(images, std::memory_order_relaxed);
+            c.liveBytes.fetch_sub(bytes);
+
+            // pairs with the waiter registering before it reads `liveBytes`: either it sees this release or the
+            // release sees it waiting.
+            if (c.waiters.load()) {
+                std::lock_guard lock{c.mutex};
+                c.released.notify_all();
+            }
+        }
+
+        // every pixel buffer carries its byte count in front of it, a crop that compacts in place still releases
+        // the whole allocation.
+        struct alignas(std::max_align_t) PixelBlock {
+            u64 bytes;
+            u64 images;
+        };
+
+        template<typename Pixel>
+        Pixel* newPixelBlock(u64 bytes, u64 images) {
+            void* block = ::operator new(sizeof(PixelBlock) + bytes);
+            return reinterpret_cast<Pixel*>(new (block) PixelBlock{bytes, images} + 1);
+        }
+
+        // an image's pixels. images created outside an op are admitted by the budget and null when it refuses
+        // them, inside one (the buffer `pad()` swaps in, the copy `topHat()` makes) they are part of work that is
+        // already running and only counted.
+        template<typename Pixel>
+        Pixel* allocatePixels(std::size_t count) {
+            const u64 bytes = u64{count} * sizeof(Pixel);
+            return tryChargePixels(bytes, 1, !memoryOpTag()) ? newPixelBlock<Pixel>(bytes, 1) : nullptr;
+        }
+
+        // an op's temporary copy of an image, part of the live bytes while it exists but not a live image.
+        template<typename Pixel>
+        Pixel* allocateScratch(std::size_t count) {
+            const u64 bytes = u64{count} * sizeof(Pixel);
+            tryChargePixels(bytes, 0, false);
+            return newPixelBlock<Pixel>(bytes, 0);
+        }
+
+        template<typename Pixel>
+        void freePixels(Pixel* d) {
+            if (!d) {
+                return;
+            }
+
+            PixelBlock*      block = reinterpret_cast<PixelBlock*>(d) - 1;
+            const PixelBlock info  = *block;
+            ::operator delete(block);
+            releasePixels(info.bytes, info.images);
+        }
+
+    } // namespace detail
+
+    // 0 removes the budget. it is an admission limit on images: loads, thumbnails and gif frames are checked
+    // before stb decodes anything, counting the buffer stb decodes into, and images created outside an op
+    // (constructors, copies, `greyScaleLum()`, `FramePool::acquire()`) when they allocate. what an op allocates
+    // while it runs is counted but never refused or held back, so live bytes can exceed the budget by what running
+    // ops hold. row buffers, pyramid arenas and encoded file bytes aren't counted at all.
+    //
+    // lowering the budget below what is live releases nothing, it only holds back new images. blocked ones
+    // re-check against the new budget and policy. under MB_BLOCK a thread that creates an image while every other
+    // one waits too, each holding images of its own, waits forever: bound the images a caller keeps at once.
+    inline void setMemoryBudget(u64 bytes, BudgetPolicy policy = MB_FAIL) {
+        detail::MemoryCounters& c = detail::MemoryCounters::get();
+        std::lock_guard         lock{c.mutex};
+        c.policy.store(policy);
+        c.budget.store(bytes);
+        ++c.generation;
+        c.released.notify_all();
+    }
+
+    // a snapshot for metrics, the counters are read one by one and can be off by an allocation in flight.
+    inline MemoryStats memoryStats() {
+        const detail::MemoryCounters& c = detail::MemoryCounters::get();
+        return {
+            .liveImages  = c.liveImages.load(std::memory_order_relaxed),
+            .liveBytes   = c.liveBytes.load(std::memory_order_relaxed),
+            .peakBytes   = c.peakBytes.load(std::memory_order_relaxed),
+            .allocations = c.allocations.load(std::memory_order_relaxed),
+            .budget      = c.budget.load(std::memory_order_relaxed),
+            .policy      = static_cast<BudgetPolicy>(c.policy.load(std::memory_order_relaxed)),
+        };
+    }
+
+    // every op that allocated pixels so far, in the order they first did.
+    inline std::vector<OpMemoryStats> memoryStatsByOp() {
+        std::vector<OpMemoryStats> stats;
+        for (const detail::MemoryOpSlot& slot : detail::MemoryCounters::get().ops) {
+            const u64 allocations = slot.allocations.load(std::memory_order_relaxed);
+            if (allocations) {
+                stats.push_back({
+                    .op          = slot.op.load(std::memory_order_acquire),
+                    .allocations = allocations,
+                    .bytes       = slot.bytes.load(std::memory_order_relaxed),
+                });
+            }
+        }
+        return stats;
+    }
+
+    // starts a new peak window at what is live now, e.g. once per metrics scrape.
+    inline void resetPeakMemory() {
+        detail::MemoryCounters& c = detail::MemoryCounters::get();
+        c.peakBytes.store(c.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+} // namespace img
+
+// `IMG_OP_SCOPE(name, image)` opens an image operation for the rest of the enclosing scope: pixels allocated in it
+// are accounted to `name` and, with `LIB_IMG_TRACE`, it is traced like `IMG_TRACE_SCOPE`. `name` has to be a string
+// literal.
+#define IMG_MEMORY_CONCAT_(a, b) a##b
+#define IMG_MEMORY_CONCAT(a, b)  IMG_MEMORY_CONCAT_(a, b)
+#define IMG_OP_SCOPE(name, image)                                                    \
+    const ::img::detail::MemoryOpScope IMG_MEMORY_CONCAT(imgOpScope_, __LINE__)((name)); \
+    IMG_TRACE_SCOPE(name, image)
+
+#endif // LIB_IMG_MEMORY_H
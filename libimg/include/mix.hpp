@@ -0,0 +1,42 @@
+#ifndef LIB_IMG_MIX_H
+#define LIB_IMG_MIX_H
+
+#include <algorithm>
+#include <limits>
+
+#include "common.hpp"
+#include "types.hpp"
+
+namespace img::detail {
+
+    // the kernels below work on `C` integer channels of type `T` (u8 or u16) per pixel, the colour channels first and
+    // alpha last. weights and gains are in memory order, intermediate values are 32 bits wide and alpha is never
+    // touched.
+
+    // px[c] = round(px[c] * gain[c]), saturating.
+    template<u32 C, typename T>
+    void gainChannels(T* px, std::size_t pixels, const arr3<float>& gain) {
+        constexpr float MAX = std::numeric_limits<T>::max();
+        for (T* p = px; pixels > 0; --pixels, p += C) {
+            for (u32 c = 0; c < 3; ++c) {
+                p[c] = static_cast<T>(std::clamp(p[c] * gain[c] + 0.5f, 0.0f, MAX));
+            }
+        }
+    }
+
+    // three colour channels (+ a) -> grey (+ a) with fixed point weights summing to 1 << 16, rounded.
+    template<u32 C, typename T>
+    void greyChannels(const T* src, T* dst, std::size_t pixels, const arr3<u32>& weight) {
+        constexpr u32 OUT = C == 4 ? 2 : 1;
+        for (std::size_t i = 0; i < pixels; ++i, src += C, dst += OUT) {
+            const u32 sum = weight[0] * src[0] + weight[1] * src[1] + weight[2] * src[2];
+            dst[0]        = static_cast<T>((sum + (1u << 15)) >> 16);
+            if constexpr (C == 4) {
+                dst[1] = src[3];
+            }
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_MIX_H
@@ -0,0 +1,200 @@
+#ifndef LIB_IMG_MORPHOLOGY_H
+#define LIB_IMG_MORPHOLOGY_H
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "border.hpp"
+#include "common.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img::detail {
+
+    // rectangular min (erode) / max (dilate) filters on interleaved 8-bit channels. the window is `k` samples
+    // anchored at `k / 2`, samples outside the image take the op's identity so they never win.
+    template<typename Op>
+    constexpr u8 MORPH_IDENTITY = std::is_same_v<Op, simd::MinU8> ? 255 : 0;
+
+    // up to this size a k-way SIMD min/max over shifted rows beats van Herk/Gil-Werman's 3 ops plus bookkeeping.
+    constexpr u32 MORPH_DIRECT_MAX_KERNEL = 7;
+
+    // bytes per column strip of the vertical pass, sized so the strip's row buffers stay in L1/L2.
+    constexpr u32 MORPH_STRIP_BYTES = 512;
+
+    template<typename Op>
+    void morphRowPass(const u8* src, u8* dst, u32 width, u32 height, u32 channels, u32 k) {
+        const std::size_t rowLen = std::size_t{width} * channels;
+        const std::size_t padPx  = std::size_t{width} + k - 1;
+        const std::size_t padLen = padPx * channels;
+        const std::size_t anchor = std::size_t{k / 2} * channels;
+
+        // small kernels read the row in place wherever the whole window is inside it, the `k / 2` pixels before
+        // and `k - 1 - k / 2` after fold only the taps that exist (the rest would be the identity).
+        const auto [interiorBegin, interiorEnd] = BorderedView::interior(width, k / 2, k - 1 - k / 2);
+
+        const std::size_t inFirst = std::size_t{interiorBegin} * channels;
+        const std::size_t inLast  = std::size_t{interiorEnd} * channels;
+
+        auto borderValue = [&](const u8* in, std::size_t e) {
+            const i64 x = static_cast<i64>(e / channels) - k / 2;
+            u8        v = MORPH_IDENTITY<Op>;
+            for (u32 t = 0; t < k; ++t) {
+                if (x + t >= 0 && x + t < i64{width}) {
+                    v = Op::scalar(v, in[static_cast<std::size_t>(x + t) * channels + e % channels]);
+                }
+            }
+            return v;
+        };
+
+        parallelFor(0, height, 16, [&](u32 y0, u32 y1) {
+            std::vector<u8> padded, g, h;
+            if (k > MORPH_DIRECT_MAX_KERNEL) {
+                padded.assign(padLen, MORPH_IDENTITY<Op>);
+                g.resize(padLen);
+                h.resize(padLen);
+            }
+
+            for (u32 y = y0; y < y1; ++y) {
+                const u8* in  = src + y * rowLen;
+                u8*       out = dst + y * rowLen;
+
+                if (k <= MORPH_DIRECT_MAX_KERNEL) {
+                    if (inFirst < inLast) {
+                        std::copy(in + inFirst - anchor, in + inLast - anchor, out + inFirst);
+                        for (u32 t = 1; t < k; ++t) {
+                            simd::apply<Op>(out + inFirst, out + inFirst,
+                                            in + inFirst - anchor + std::size_t{t} * channels, inLast - inFirst);
+                        }
+                    }
+                    for (std::size_t e = 0; e < inFirst; ++e) {
+                        out[e] = borderValue(in, e);
+                    }
+                    for (std::size_t e = inLast; e < rowLen; ++e) {
+                        out[e] = borderValue(in, e);
+                    }
+                    continue;
+                }
+
+                std::copy(in, in + rowLen, padded.data() + anchor);
+
+                // van Herk/Gil-Werman: prefix (g) and suffix (h) runs inside blocks of `k` samples, the window
+                // starting at `i` is then op(h[i], g[i + k - 1]) whatever `k` is.
+                for (std::size_t block = 0; block < padPx; block += k) {
+                    const std::size_t first = block * channels;
+                    const std::size_t last  = std::min(padPx, block + k) * channels - channels;
+
+                    std::copy_n(padded.data() + first, channels, g.data() + first);
+                    for (std::size_t e = first + channels; e < last + channels; ++e) {
+                        g[e] = Op::scalar(g[e - channels], padded[e]);
+                    }
+
+                    std::copy_n(padded.data() + last, channels, h.data() + last);
+                    for (std::size_t e = last; e-- > first;) {
+                        h[e] = Op::scalar(h[e + channels], padded[e]);
+                    }
+                }
+                simd::apply<Op>(out, h.data(), g.data() + std::size_t{k - 1} * channels, rowLen);
+            }
+        });
+    }
+
+    template<typename Op>
+    void morphColPass(const u8* src, u8* dst, u32 width, u32 height, u32 channels, u32 k) {
+        const std::size_t rowLen = std::size_t{width} * channels;
+        const u32         strips = static_cast<u32>((rowLen + MORPH_STRIP_BYTES - 1) / MORPH_STRIP_BYTES);
+        const u32         anchor = k / 2;
+        const u32         padLen = height + k - 1;
+
+        parallelFor(0, strips, 1, [&](u32 s0, u32 s1) {
+            const std::vector<u8> identityRow(MORPH_STRIP_BYTES, MORPH_IDENTITY<Op>);
+            std::vector<u8>       hCur, gNext;
+            if (k > MORPH_DIRECT_MAX_KERNEL) {
+                hCur.resize(std::size_t{k} * MORPH_STRIP_BYTES);
+                gNext.resize(std::size_t{k} * MORPH_STRIP_BYTES);
+            }
+
+            for (u32 s = s0; s < s1; ++s) {
+                const std::size_t c0 = std::size_t{s} * MORPH_STRIP_BYTES;
+                const std::size_t n  = std::min<std::size_t>(MORPH_STRIP_BYTES, rowLen - c0);
+
+                auto rowAt = [&](u32 j) -> const u8* {
+                    return (j < anchor || j - anchor >= height) ? identityRow.data() : src + (j - anchor) * rowLen + c0;
+                };
+
+                if (k <= MORPH_DIRECT_MAX_KERNEL) {
+                    for (u32 y = 0; y < height; ++y) {
+                        u8* out = dst + y * rowLen + c0;
+                        std::copy(rowAt(y), rowAt(y) + n, out);
+                        for (u32 t = 1; t < k; ++t) {
+                            simd::apply<Op>(out, out, rowAt(y + t), n);
+                        }
+                    }
+                    continue;
+                }
+
+                // same block decomposition as the row pass, but only the suffix rows of the current block and the
+                // prefix rows of the next one are alive, so the scratch is 2 * k strip rows not the whole column.
+                auto buildSuffix = [&](u32 block) {
+                    const u32 begin = block * k;
+                    const u32 end   = std::min(padLen, begin + k);
+                    for (u32 j = end; j-- > begin;) {
+                        u8* row = hCur.data() + std::size_t{j - begin} * MORPH_STRIP_BYTES;
+                        if (j == end - 1) {
+                            std::copy(rowAt(j), rowAt(j) + n, row);
+                        } else {
+                            simd::apply<Op>(row, row + MORPH_STRIP_BYTES, rowAt(j), n);
+                        }
+                    }
+                };
+
+                auto buildPrefix = [&](u32 block) {
+                    const u32 begin = block * k;
+                    const u32 end   = std::min(padLen, begin + k);
+                    for (u32 j = begin; j < end; ++j) {
+                        u8* row = gNext.data() + std::size_t{j - begin} * MORPH_STRIP_BYTES;
+                        if (j == begin) {
+                            std::copy(rowAt(j), rowAt(j) + n, row);
+                        } else {
+                            simd::apply<Op>(row, row - MORPH_STRIP_BYTES, rowAt(j), n);
+                        }
+                    }
+                };
+
+                buildSuffix(0);
+                for (u32 block = 0; block * k < height; ++block) {
+                    const u32 begin = block * k;
+                    if (begin + k < padLen) {
+                        buildPrefix(block + 1);
+                    }
+
+                    for (u32 i = begin, end = std::min(height, begin + k); i < end; ++i) {
+                        u8*       out = dst + i * rowLen + c0;
+                        const u8* hr  = hCur.data() + std::size_t{i - begin} * MORPH_STRIP_BYTES;
+                        if (i == begin) {
+                            std::copy(hr, hr + n, out);
+                        } else {
+                            simd::apply<Op>(out, hr, gNext.data() + std::size_t{i - begin - 1} * MORPH_STRIP_BYTES, n);
+                        }
+                    }
+
+                    if (begin + k < height) {
+                        buildSuffix(block + 1);
+                    }
+                }
+            }
+        });
+    }
+
+    // separable rectangle: rows into `tmp`, then columns back into `data`.
+    template<typename Op>
+    void morphRect(u8* data, u8* tmp, u32 width, u32 height, u32 channels, u32 kernelWidth, u32 kernelHeight) {
+        morphRowPass<Op>(data, tmp, width, height, channels, kernelWidth);
+        morphColPass<Op>(tmp, data, width, height, channels, kernelHeight);
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_MORPHOLOGY_H
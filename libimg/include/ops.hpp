@@ -1,32 +1,69 @@
 #ifndef LIB_IMG_PIXEL_OPS_2_H
 #define LIB_IMG_PIXEL_OPS_2_H
 
-#include <immintrin.h>
+#include <algorithm>
+#include <functional>
 
 #include "common.hpp"
+#include "pixel_traits.hpp"
 #include "types.hpp"
 #include "utils.hpp"
 
 namespace img {
 
-    template<typename pixel_t>
-        requires is_pixel_type<pixel_t>
-    struct PIXEL_NOR_OP {
-        friend pixel_t& operator~(pixel_t& _this) {
-            if constexpr (is_1_channel_pixel<pixel_t> || is_2_channel_pixel<pixel_t>) {
-                _this.g = ~(_this.g);
+    namespace detail {
+
+        // LHS[i] = op(LHS[i], RHS[i]) over every channel, widened and clamped back to the channel range.
+        template<typename Pixel, typename Op>
+        Pixel combineChannels(Pixel LHS, const Pixel& RHS, Op op) {
+            using Wide_t = typename pixel_traits<Pixel>::Wide_t;
+
+            auto*       l = channelsOf(LHS);
+            const auto* r = channelsOf(RHS);
+            for (u32 i = 0; i < pixel_traits<Pixel>::CHANNELS; ++i) {
+                l[i] = clampColorChanel<Pixel>(op(Wide_t{l[i]}, Wide_t{r[i]}));
             }
+            return LHS;
+        }
+
+        // `arr` is in logical order (g, a for grey pixels, r, g, b, a otherwise), grey pixels take two values and
+        // colour pixels three or four. values past the pixel's channels are ignored, without a fourth value alpha
+        // is kept.
+        template<typename Pixel, typename Array, typename Op>
+        Pixel& combineArray(Pixel& LHS, const Array& arr, Op op) {
+            using Traits = pixel_traits<Pixel>;
+            static_assert((Traits::CHANNELS <= 2) == (std::tuple_size_v<Array> <= 2),
+                          "grey pixels take two values, colour pixels three or four");
+
+            using Wide_t = typename Traits::Wide_t;
 
-            if constexpr (is_3_channel_pixel<pixel_t> || is_4_channel_pixel<pixel_t>) {
-                _this.r = ~(_this.r);
-                _this.g = ~(_this.g);
-                _this.b = ~(_this.b);
+            constexpr u32 N = std::min<u32>(Traits::CHANNELS, std::tuple_size_v<Array>);
+
+            auto* c = channelsOf(LHS);
+            for (u32 k = 0; k < N; ++k) {
+                const u32 i = Traits::INDEX[k];
+                c[i]        = clampColorChanel<Pixel>(op(Wide_t{c[i]}, arr[k]));
             }
+            return LHS;
+        }
+
+    } // namespace detail
 
-            // if constexpr (is_4_channel_pixel<pixel_t>) {
-            //     _this.a = ~(_this.a);
-            // }
+    // the operators below are written once against `pixel_traits` and mixed into every pixel type.
+
+    template<typename pixel_t>
+        requires is_pixel_type<pixel_t>
+    struct PIXEL_NOR_OP {
+        // inverts the colour channels, alpha is kept.
+        friend pixel_t& operator~(pixel_t& _this)
+            requires std::is_integral_v<pixel_channel_t<pixel_t>>
+        {
+            using Traits = pixel_traits<pixel_t>;
 
+            auto* c = channelsOf(_this);
+            for (u32 i = 0; i < Traits::COLOUR_CHANNELS; ++i) {
+                c[i] = static_cast<pixel_channel_t<pixel_t>>(~c[i]);
+            }
             return _this;
         }
     };
@@ -35,109 +72,20 @@ namespace img {
         requires is_pixel_type<pixel_t>
     struct PIXEL_ADD_OP {
         [[nodiscard]] pixel_t friend operator+(const pixel_t& LHS, const pixel_t& RHS) {
-            pixel_t tmp;
-
-            if constexpr (std::is_same_v<pixel_t, GREY8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + RHS.g);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, GREYa8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + RHS.g);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a + RHS.a);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGB8> || std::is_same_v<pixel_t, BGR8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r + RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b + RHS.b);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGBa8> || std::is_same_v<pixel_t, BGRa8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r + RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b + RHS.b);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a + RHS.a);
-            }
-
-            return tmp;
+            return detail::combineChannels(LHS, RHS, std::plus<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         [[nodiscard]] friend pixel_t operator+(const pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-
-            pixel_t tmp;
-
-            if constexpr (is_1_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + arr[0]);
-            }
-
-            if constexpr (is_2_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + arr[0]);
-                if constexpr (sz == 2) {
-                    tmp.a = clampColorChanel<pixel_t>(LHS.a + arr[1]);
-                }
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                tmp.r = clampColorChanel<pixel_t>(LHS.r + arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b + arr[2]);
-            }
-
-            if constexpr (is_4_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                tmp.r = clampColorChanel<pixel_t>(LHS.r + arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g + arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b + arr[2]);
-                if constexpr (sz == 4) {
-                    tmp.a = clampColorChanel<pixel_t>(LHS.a + arr[3]);
-                }
-            }
-
-            return tmp;
+            pixel_t tmp = LHS;
+            return detail::combineArray(tmp, arr, std::plus<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         friend pixel_t& operator+=(pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-
-            if constexpr (is_1_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g + arr[0]);
-            }
-
-            if constexpr (is_2_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g + arr[0]);
-                if constexpr (sz == 2) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a + arr[1]);
-                }
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r + arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g + arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b + arr[2]);
-            }
-
-            if constexpr (is_4_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r + arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g + arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b + arr[2]);
-                if constexpr (sz == 4) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a + arr[3]);
-                }
-            }
-
-            return LHS;
+            return detail::combineArray(LHS, arr, std::plus<>{});
         }
     };
 
@@ -145,102 +93,20 @@ namespace img {
         requires is_pixel_type<pixel_t>
     struct PIXEL_SUB_OP {
         [[nodiscard]] friend pixel_t operator-(const pixel_t& LHS, const pixel_t& RHS) {
-            pixel_t tmp;
-
-            if constexpr (std::is_same_v<pixel_t, GREY8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - RHS.g);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, GREYa8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - RHS.g);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a - RHS.a);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGB8> || std::is_same_v<pixel_t, BGR8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r - RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b - RHS.b);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGBa8> || std::is_same_v<pixel_t, BGRa8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r - RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b - RHS.b);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a - RHS.a);
-            }
-
-            return tmp;
+            return detail::combineChannels(LHS, RHS, std::minus<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         [[nodiscard]] friend pixel_t operator-(const pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-            pixel_t tmp;
-
-            if constexpr (sz == 1 && is_1_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - arr[0]);
-            }
-
-            if constexpr (sz == 2 && is_2_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - arr[0]);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a - arr[1]);
-            }
-
-            if constexpr (sz == 3 && (is_3_channel_pixel<pixel_t>)) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r - arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b - arr[2]);
-            }
-
-            if constexpr ((sz == 4 || sz == 3) && is_4_channel_pixel<pixel_t>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r - arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g - arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b - arr[2]);
-                if constexpr (sz == 4) {
-                    tmp.a = clampColorChanel<pixel_t>(LHS.a - arr[3]);
-                }
-            }
-
-            return tmp;
+            pixel_t tmp = LHS;
+            return detail::combineArray(tmp, arr, std::minus<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         friend pixel_t& operator-=(pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-
-            if constexpr (is_1_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g - arr[0]);
-            }
-
-            if constexpr (is_2_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g - arr[0]);
-                if constexpr (sz == 2) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a - arr[1]);
-                }
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r - arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g - arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b - arr[2]);
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t> || is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r - arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g - arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b - arr[2]);
-                if constexpr (sz == 4) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a - arr[3]);
-                }
-            }
-
-            return LHS;
+            return detail::combineArray(LHS, arr, std::minus<>{});
         }
     };
 
@@ -248,101 +114,20 @@ namespace img {
         requires is_pixel_type<pixel_t>
     struct PIXEL_MUL_OP {
         [[nodiscard]] friend pixel_t operator*(const pixel_t& LHS, const pixel_t& RHS) {
-            pixel_t tmp;
-
-            if constexpr (std::is_same_v<pixel_t, GREY8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * RHS.g);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, GREYa8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * RHS.g);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a * RHS.a);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGB8> || std::is_same_v<pixel_t, BGR8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r * RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b * RHS.b);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGBa8> || std::is_same_v<pixel_t, BGRa8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r * RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b * RHS.b);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a * RHS.a);
-            }
-
-            return tmp;
+            return detail::combineChannels(LHS, RHS, std::multiplies<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         [[nodiscard]] friend pixel_t operator*(const pixel_t& LHS, const array<U, sz>& arr) {
-            pixel_t tmp;
-
-            if constexpr (sz == 1 && is_1_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * arr[0]);
-            }
-
-            if constexpr (sz == 2 && is_2_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * arr[0]);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a * arr[1]);
-            }
-
-            if constexpr (sz == 3 && (is_3_channel_pixel<pixel_t>)) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r * arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b * arr[2]);
-            }
-
-            if constexpr ((sz == 4 || sz == 3) && is_4_channel_pixel<pixel_t>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r * arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g * arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b * arr[2]);
-                if constexpr (sz == 4) {
-                    tmp.a = clampColorChanel<pixel_t>(LHS.a * arr[3]);
-                }
-            }
-
-            return tmp;
+            pixel_t tmp = LHS;
+            return detail::combineArray(tmp, arr, std::multiplies<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         friend pixel_t& operator*=(pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-
-            if constexpr (is_1_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g * arr[0]);
-            }
-
-            if constexpr (is_2_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g * arr[0]);
-                if constexpr (sz == 2) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a * arr[1]);
-                }
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r * arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g * arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b * arr[2]);
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t> || is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r * arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g * arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b * arr[2]);
-                if constexpr (sz == 4) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a * arr[3]);
-                }
-            }
-
-            return LHS;
+            return detail::combineArray(LHS, arr, std::multiplies<>{});
         }
     };
 
@@ -350,105 +135,23 @@ namespace img {
         requires is_pixel_type<pixel_t>
     struct PIXEL_DEV_OP {
         [[nodiscard]] friend pixel_t operator/(const pixel_t& LHS, const pixel_t& RHS) {
-            pixel_t tmp;
-
-            if constexpr (std::is_same_v<pixel_t, GREY8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / RHS.g);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, GREYa8>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / RHS.g);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a / RHS.a);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGB8> || std::is_same_v<pixel_t, BGR8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r / RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b / RHS.b);
-            }
-
-            if constexpr (std::is_same_v<pixel_t, RGBa8> || std::is_same_v<pixel_t, BGRa8>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r / RHS.r);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / RHS.g);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b / RHS.b);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a / RHS.a);
-            }
-
-            return tmp;
+            return detail::combineChannels(LHS, RHS, std::divides<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         [[nodiscard]] friend pixel_t operator/(const pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-            pixel_t tmp;
-
-            if constexpr (sz == 1 && is_1_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / arr[0]);
-            }
-
-            if constexpr (sz == 2 && is_2_channel_pixel<pixel_t>) {
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / arr[0]);
-                tmp.a = clampColorChanel<pixel_t>(LHS.a / arr[1]);
-            }
-
-            if constexpr (sz == 3 && (is_3_channel_pixel<pixel_t>)) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r / arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b / arr[2]);
-            }
-
-            if constexpr ((sz == 4 || sz == 3) && is_4_channel_pixel<pixel_t>) {
-                tmp.r = clampColorChanel<pixel_t>(LHS.r / arr[0]);
-                tmp.g = clampColorChanel<pixel_t>(LHS.g / arr[1]);
-                tmp.b = clampColorChanel<pixel_t>(LHS.b / arr[2]);
-                if constexpr (sz == 4) {
-                    tmp.a = clampColorChanel<pixel_t>(LHS.a / arr[3]);
-                }
-            }
-
-            return tmp;
+            pixel_t tmp = LHS;
+            return detail::combineArray(tmp, arr, std::divides<>{});
         }
 
         template<typename U, std::size_t sz, template<class, std::size_t> typename array>
             requires std::is_arithmetic_v<U> && is_allowed_arr_sz<U, sz>
         friend pixel_t& operator/=(pixel_t& LHS, const array<U, sz>& arr) {
-            // TODO: fix this mess!
-
-            if constexpr (is_1_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g / arr[0]);
-            }
-
-            if constexpr (is_2_channel_pixel<pixel_t>) {
-                static_assert(sz == 1 || sz == 2);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g / arr[0]);
-                if constexpr (sz == 2) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a / arr[1]);
-                }
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r / arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g / arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b / arr[2]);
-            }
-
-            if constexpr (is_3_channel_pixel<pixel_t> || is_3_channel_pixel<pixel_t>) {
-                static_assert(sz == 3 || sz == 4);
-                LHS.r = clampColorChanel<pixel_t>(LHS.r / arr[0]);
-                LHS.g = clampColorChanel<pixel_t>(LHS.g / arr[1]);
-                LHS.b = clampColorChanel<pixel_t>(LHS.b / arr[2]);
-                if constexpr (sz == 4) {
-                    LHS.a = clampColorChanel<pixel_t>(LHS.a / arr[3]);
-                }
-            }
-
-            return LHS;
+            return detail::combineArray(LHS, arr, std::divides<>{});
         }
     };
 
 } // namespace img
 
-#endif // LIB_IMG_PIXEL_OPS_H
\ No newline at end of file
+#endif // LIB_IMG_PIXEL_OPS_H
@@ -0,0 +1,162 @@
+#ifndef LIB_IMG_ORIENTATION_H
+#define LIB_IMG_ORIENTATION_H
+
+#include <algorithm>
+#include <cstring>
+
+#include "common.hpp"
+#include "flip.hpp"
+#include "img_assert.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // the eight flip/rotate symmetries of a rectangle. each is a transpose (or not) followed by mirroring the
+    // transposed image, the bits are OR_FLIP_X, OR_FLIP_Y and OR_TRANSPOSE.
+    enum Orientation : u8 {
+        OR_IDENTITY     = 0,
+        OR_FLIP_X       = 1, // mirror left-right
+        OR_FLIP_Y       = 2, // mirror top-bottom
+        OR_ROTATE_180   = 3,
+        OR_TRANSPOSE    = 4, // mirror about the main diagonal
+        OR_ROTATE_RIGHT = 5, // 90 degrees clockwise
+        OR_ROTATE_LEFT  = 6, // 90 degrees counter-clockwise
+        OR_TRANSVERSE   = 7, // mirror about the anti-diagonal
+    };
+
+    // `first` followed by `then`. transposing turns a pending left-right mirror into a top-bottom one and back.
+    constexpr Orientation composeOrientation(Orientation first, Orientation then) {
+        const u32 fx    = first & OR_FLIP_X, fy = (first & OR_FLIP_Y) >> 1;
+        const u32 flips = (then & OR_TRANSPOSE) ? (fx << 1 | fy) : (fx | fy << 1);
+        return static_cast<Orientation>(((first ^ then) & OR_TRANSPOSE) | ((flips ^ then) & (OR_FLIP_X | OR_FLIP_Y)));
+    }
+
+    // what undoes `o`, only the two quarter turns aren't their own inverse.
+    constexpr Orientation invertOrientation(Orientation o) {
+        switch (o) {
+            case OR_ROTATE_RIGHT: return OR_ROTATE_LEFT;
+            case OR_ROTATE_LEFT: return OR_ROTATE_RIGHT;
+            case OR_IDENTITY:
+            case OR_FLIP_X:
+            case OR_FLIP_Y:
+            case OR_ROTATE_180:
+            case OR_TRANSPOSE:
+            case OR_TRANSVERSE: break;
+        }
+        return o;
+    }
+
+    // the orientation that displays a picture upright given its EXIF orientation tag (1 .. 8), anything else is
+    // treated as upright.
+    constexpr Orientation orientationFromExif(u16 tag) {
+        constexpr Orientation TAGS[9] = {OR_IDENTITY,
+                                         OR_IDENTITY,
+                                         OR_FLIP_X,
+                                         OR_ROTATE_180,
+                                         OR_FLIP_Y,
+                                         OR_TRANSPOSE,
+                                         OR_ROTATE_RIGHT,
+                                         OR_TRANSVERSE,
+                                         OR_ROTATE_LEFT};
+        return tag < 9 ? TAGS[tag] : OR_IDENTITY;
+    }
+
+} // namespace img
+
+namespace img::detail {
+
+    // transposed copies go through square tiles so both sides stay within a few cache lines.
+    constexpr u32 ORIENT_TILE = 32;
+
+    // the 180 degree turn pairs row y with row h - 1 - y, mirrors both and swaps them.
+    template<u32 C>
+    void rotateHalfTurn(u8* data, u32 width, u32 height) {
+        const std::size_t rowBytes = std::size_t{width} * C;
+        parallelFor(0, (height + 1) / 2, 16, [&](u32 y0, u32 y1) {
+            for (u32 y = y0; y < y1; ++y) {
+                u8* top = data + y * rowBytes;
+                u8* bot = data + (height - 1 - y) * rowBytes;
+                flipRow<C>(top, width);
+                if (top != bot) {
+                    flipRow<C>(bot, width);
+                    swapRows(top, bot, rowBytes);
+                }
+            }
+        });
+    }
+
+    // dst (height x width) = `o` applied to src (width x height) for an orientation with the transpose bit set,
+    // destination pixel (x, y) reads source pixel (flipY ? width - 1 - y : y, flipX ? height - 1 - x : x).
+    template<u32 C>
+    void orientTransposed(const u8* src, u8* dst, u32 width, u32 height, Orientation o) {
+        const bool fx = o & OR_FLIP_X, fy = o & OR_FLIP_Y;
+
+        const u32 tilesX = (height + ORIENT_TILE - 1) / ORIENT_TILE;
+        const u32 tilesY = (width + ORIENT_TILE - 1) / ORIENT_TILE;
+        parallelFor(0, tilesX * tilesY, 4, [&](u32 t0, u32 t1) {
+            for (u32 t = t0; t < t1; ++t) {
+                const u32 x0 = (t % tilesX) * ORIENT_TILE, x1 = std::min(height, x0 + ORIENT_TILE);
+                const u32 y0 = (t / tilesX) * ORIENT_TILE, y1 = std::min(width, y0 + ORIENT_TILE);
+
+                // walking a destination row walks a source column, up or down depending on the mirror.
+                const std::ptrdiff_t step = (fx ? -1 : 1) * static_cast<std::ptrdiff_t>(std::size_t{width} * C);
+                const std::size_t    sy0  = fx ? height - 1 - x0 : x0;
+                for (u32 y = y0; y < y1; ++y) {
+                    const u32      sx  = fy ? width - 1 - y : y;
+                    std::ptrdiff_t at  = static_cast<std::ptrdiff_t>((sy0 * width + sx) * C);
+                    u8*            out = dst + (std::size_t{y} * height + x0) * C;
+                    for (u32 x = x0; x < x1; ++x, out += C, at += step) {
+                        std::memcpy(out, src + at, C);
+                    }
+                }
+            }
+        });
+    }
+
+    // the orientations without the transpose bit keep the dimensions and are applied in place.
+    template<u32 C>
+    void orientInPlace(u8* data, u32 width, u32 height, Orientation o) {
+        switch (o) {
+            case OR_FLIP_X: flipColumns<C>(data, width, height); break;
+            case OR_FLIP_Y: flipRows(data, height, std::size_t{width} * C); break;
+            case OR_ROTATE_180: rotateHalfTurn<C>(data, width, height); break;
+            case OR_IDENTITY:
+            case OR_TRANSPOSE:
+            case OR_ROTATE_RIGHT:
+            case OR_ROTATE_LEFT:
+            case OR_TRANSVERSE: break;
+        }
+    }
+
+    inline void orientInPlace(u8* data, u32 width, u32 height, std::size_t pixelSize, Orientation o) {
+        switch (pixelSize) {
+            case 1: orientInPlace<1>(data, width, height, o); break;
+            case 2: orientInPlace<2>(data, width, height, o); break;
+            case 3: orientInPlace<3>(data, width, height, o); break;
+            case 4: orientInPlace<4>(data, width, height, o); break;
+            case 6: orientInPlace<6>(data, width, height, o); break;
+            case 8: orientInPlace<8>(data, width, height, o); break;
+            case 12: orientInPlace<12>(data, width, height, o); break;
+            case 16: orientInPlace<16>(data, width, height, o); break;
+            default: IMG_ABORT("unsupported pixel size: %zu", pixelSize);
+        }
+    }
+
+    inline void orientTransposed(const u8* src, u8* dst, u32 width, u32 height, std::size_t pixelSize, Orientation o) {
+        switch (pixelSize) {
+            case 1: orientTransposed<1>(src, dst, width, height, o); break;
+            case 2: orientTransposed<2>(src, dst, width, height, o); break;
+            case 3: orientTransposed<3>(src, dst, width, height, o); break;
+            case 4: orientTransposed<4>(src, dst, width, height, o); break;
+            case 6: orientTransposed<6>(src, dst, width, height, o); break;
+            case 8: orientTransposed<8>(src, dst, width, height, o); break;
+            case 12: orientTransposed<12>(src, dst, width, height, o); break;
+            case 16: orientTransposed<16>(src, dst, width, height, o); break;
+            default: IMG_ABORT("unsupported pixel size: %zu", pixelSize);
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_ORIENTATION_H
@@ -0,0 +1,221 @@
+#ifndef LIB_IMG_PARALLEL_H
+#define LIB_IMG_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "types.hpp"
+
+// number of threads `parallelFor` spreads work over, the caller included, 0 picks the hardware concurrency.
+#ifndef LIB_IMG_THREAD_COUNT
+    #define LIB_IMG_THREAD_COUNT 0
+#endif
+
+namespace img {
+
+    class LIB_IMG_PUBLIC ThreadPool {
+    public:
+        explicit ThreadPool(u32 threadCount) {
+            m_workers.reserve(threadCount);
+            for (u32 i = 0; i < threadCount; ++i) {
+                m_workers.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{m_mutex};
+                m_stop = true;
+            }
+            m_cv.notify_all();
+
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        // the calling thread always takes part in `parallelFor`, so the shared pool keeps one core for it.
+        static ThreadPool& global() {
+            static ThreadPool pool{
+                std::max(1u, LIB_IMG_THREAD_COUNT ? LIB_IMG_THREAD_COUNT : std::thread::hardware_concurrency()) - 1};
+            return pool;
+        }
+
+        void submit(std::function<void()> task) {
+            // notify under the lock, the task may finish and let its owner destroy the pool before we return.
+            std::lock_guard lock{m_mutex};
+            if (m_taskCount == m_tasks.size()) {
+                growTasks();
+            }
+            m_tasks[(m_taskHead + m_taskCount) & (m_tasks.size() - 1)] = std::move(task);
+            ++m_taskCount;
+            m_cv.notify_one();
+        }
+
+        u32 threadCount() const {
+            return static_cast<u32>(m_workers.size());
+        }
+
+    private:
+        void workerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock{m_mutex};
+                    m_cv.wait(lock, [this] { return m_stop || m_taskCount != 0; });
+                    if (m_stop && m_taskCount == 0) {
+                        return;
+                    }
+                    task       = std::move(m_tasks[m_taskHead]);
+                    m_taskHead = (m_taskHead + 1) & (m_tasks.size() - 1);
+                    --m_taskCount;
+                }
+                task();
+            }
+        }
+
+        // the queue is a power of two ring that only ever grows, once it's large enough queueing allocates nothing
+        // (a deque frees and reallocates its blocks as the queue moves through them).
+        void growTasks() {
+            std::vector<std::function<void()>> grown(std::max<std::size_t>(16, m_tasks.size() * 2));
+            for (std::size_t i = 0; i < m_taskCount; ++i) {
+                grown[i] = std::move(m_tasks[(m_taskHead + i) & (m_tasks.size() - 1)]);
+            }
+            m_tasks.swap(grown);
+            m_taskHead = 0;
+        }
+
+    private:
+        std::vector<std::thread>           m_workers;
+        std::vector<std::function<void()>> m_tasks;
+        std::size_t                        m_taskHead  = 0;
+        std::size_t                        m_taskCount = 0;
+        std::mutex                         m_mutex;
+        std::condition_variable            m_cv;
+        bool                               m_stop = false;
+    };
+
+    namespace detail {
+
+        // what a `parallelFor` call shares with the helpers it queues. a helper can start after the call has
+        // returned and still reads the chunk counter, so the state lives until the last reference is dropped and is
+        // then put on a free list instead of being freed, calls in steady state allocate nothing.
+        struct ParallelForState {
+            std::atomic<u32> next{0};
+            std::atomic<u32> done{0};
+            std::atomic<u32> refs{0};
+
+            u32 begin, end, grain, chunks;
+
+            void (*call)(void* fn, u32 b, u32 e);
+            void* fn;
+
+            void run() {
+                for (u32 c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+                    const u32 b = begin + c * grain;
+                    const u32 e = static_cast<u32>(std::min<u64>(end, u64{b} + grain));
+                    call(fn, b, e);
+                    if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+                        done.notify_all();
+                    }
+                }
+            }
+
+            static ParallelForState* acquire(u32 refCount) {
+                ParallelForState* state = nullptr;
+                {
+                    std::lock_guard lock{freeMutex()};
+                    if (!freeList().empty()) {
+                        state = freeList().back();
+                        freeList().pop_back();
+                    }
+                }
+                if (!state) {
+                    state = new ParallelForState;
+                }
+
+                state->next.store(0, std::memory_order_relaxed);
+                state->done.store(0, std::memory_order_relaxed);
+                state->refs.store(refCount, std::memory_order_relaxed);
+                return state;
+            }
+
+            void release() {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard lock{freeMutex()};
+                    freeList().push_back(this);
+                }
+            }
+
+            // states are never freed, there are only ever as many as there were calls in flight at once. the list
+            // and its lock aren't either, the global pool's workers can still return a state while statics are
+            // being destroyed at exit.
+            static std::vector<ParallelForState*>& freeList() {
+                static auto* list = new std::vector<ParallelForState*>;
+                return *list;
+            }
+
+            static std::mutex& freeMutex() {
+                static auto* mutex = new std::mutex;
+                return *mutex;
+            }
+        };
+
+    } // namespace detail
+
+    // splits [begin, end) into `grain` sized chunks and calls `fn(chunkBegin, chunkEnd)` on the global pool,
+    // the caller claims chunks too, so nested calls from inside a pool task can't deadlock.
+    template<typename Fn>
+    void parallelFor(u32 begin, u32 end, u32 grain, Fn&& fn) {
+        if (end <= begin) {
+            return;
+        }
+
+        grain             = std::max(grain, 1u);
+        const u32  chunks = static_cast<u32>((u64{end} - begin + grain - 1) / grain);
+        ThreadPool& pool  = ThreadPool::global();
+
+        if (chunks == 1 || pool.threadCount() == 0) {
+            fn(begin, end);
+            return;
+        }
+
+        using Fn_t = std::remove_reference_t<Fn>;
+
+        const u32                 helpers = std::min(pool.threadCount(), chunks - 1);
+        detail::ParallelForState* state   = detail::ParallelForState::acquire(helpers + 1);
+        state->begin                      = begin;
+        state->end                        = end;
+        state->grain                      = grain;
+        state->chunks                     = chunks;
+        state->call                       = [](void* f, u32 b, u32 e) { (*static_cast<Fn_t*>(f))(b, e); };
+        state->fn                         = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+
+        // a single pointer fits std::function's inline storage.
+        for (u32 i = 0; i < helpers; ++i) {
+            pool.submit([state] {
+                state->run();
+                state->release();
+            });
+        }
+        state->run();
+
+        for (u32 d; (d = state->done.load(std::memory_order_acquire)) != chunks;) {
+            state->done.wait(d, std::memory_order_acquire);
+        }
+        state->release();
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_PARALLEL_H
@@ -93,7 +93,84 @@ namespace img {
         }
     };
 
-    struct HDR32 {};
+    //////////////16 BIT//////////////
+
+    // 16-bit images load, save, add, subtract, invert, convert to grey, colour mask, take noise and build pyramids
+    // at full depth. the filters (erode/dilate and the morphology built on them, medianBlur, sobel/scharr/canny, the
+    // warps and rotate()), applyLut and the colour space conversions stay 8-bit only.
+
+    struct GREY16 : public PIXEL_NOR_OP<GREY16>,
+                    public PIXEL_ADD_OP<GREY16>,
+                    public PIXEL_SUB_OP<GREY16>,
+                    public PIXEL_MUL_OP<GREY16>,
+                    public PIXEL_DEV_OP<GREY16> {
+        u16 g;
+
+        operator u16() const {
+            return g;
+        }
+    };
+
+    struct GREYa16 : public PIXEL_NOR_OP<GREYa16>,
+                     public PIXEL_ADD_OP<GREYa16>,
+                     public PIXEL_SUB_OP<GREYa16>,
+                     public PIXEL_MUL_OP<GREYa16>,
+                     public PIXEL_DEV_OP<GREYa16> {
+        u16 g, a;
+
+        operator arr2<u16>() const {
+            return {g, a};
+        }
+    };
+
+    struct RGB16 : public PIXEL_NOR_OP<RGB16>,
+                   public PIXEL_ADD_OP<RGB16>,
+                   public PIXEL_SUB_OP<RGB16>,
+                   public PIXEL_MUL_OP<RGB16>,
+                   public PIXEL_DEV_OP<RGB16> {
+        u16 r, g, b;
+
+        operator arr3<u16>() const {
+            return {r, g, b};
+        }
+    };
+
+    struct RGBa16 : public PIXEL_NOR_OP<RGBa16>,
+                    public PIXEL_ADD_OP<RGBa16>,
+                    public PIXEL_SUB_OP<RGBa16>,
+                    public PIXEL_MUL_OP<RGBa16>,
+                    public PIXEL_DEV_OP<RGBa16> {
+        u16 r, g, b, a;
+
+        operator arr4<u16>() const {
+            return {r, g, b, a};
+        }
+    };
+
+    //////////////HDR//////////////
+
+    // float channels are never clamped and have no bitwise inverse.
+    struct HDR32 : public PIXEL_ADD_OP<HDR32>,
+                   public PIXEL_SUB_OP<HDR32>,
+                   public PIXEL_MUL_OP<HDR32>,
+                   public PIXEL_DEV_OP<HDR32> {
+        float r, g, b;
+
+        operator arr3<float>() const {
+            return {r, g, b};
+        }
+    };
+
+    struct HDRa32 : public PIXEL_ADD_OP<HDRa32>,
+                    public PIXEL_SUB_OP<HDRa32>,
+                    public PIXEL_MUL_OP<HDRa32>,
+                    public PIXEL_DEV_OP<HDRa32> {
+        float r, g, b, a;
+
+        operator arr4<float>() const {
+            return {r, g, b, a};
+        }
+    };
 
 } // namespace img
 
@@ -0,0 +1,119 @@
+#ifndef LIB_IMG_PIXEL_TRAITS_H
+#define LIB_IMG_PIXEL_TRAITS_H
+
+#include <array>
+#include <limits>
+#include <type_traits>
+
+#include "common.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    // `pixel_traits<P>::ALPHA` of the pixel types without alpha.
+    constexpr u32 NO_ALPHA = ~0u;
+
+    // runtime tag of a pixel type, one bit each.
+    enum PixelFmt : u16 {
+        PF_UNKOWN  = 0X0000,
+        PF_GREY8   = 0x0001,
+        PF_GREYa8  = 0x0002,
+        PF_RGB8    = 0x0004,
+        PF_RGBa8   = 0x0020,
+        PF_BGR8    = 0x0100,
+        PF_BGRa8   = 0x0800,
+        PF_GREY16  = 0x0008,
+        PF_GREYa16 = 0x0010,
+        PF_RGB16   = 0x0040,
+        PF_RGBa16  = 0x0080,
+        PF_HDR32   = 0x0200,
+        PF_HDRa32  = 0x0400,
+    };
+
+    constexpr const char* pixelFmtName(PixelFmt pf) {
+        switch (pf) {
+            case PF_GREY8: return "GREY8";
+            case PF_GREYa8: return "GREYa8";
+            case PF_RGB8: return "RGB8";
+            case PF_RGBa8: return "RGBa8";
+            case PF_BGR8: return "BGR8";
+            case PF_BGRa8: return "BGRa8";
+            case PF_GREY16: return "GREY16";
+            case PF_GREYa16: return "GREYa16";
+            case PF_RGB16: return "RGB16";
+            case PF_RGBa16: return "RGBa16";
+            case PF_HDR32: return "HDR32";
+            case PF_HDRa32: return "HDRa32";
+            case PF_UNKOWN: break;
+        }
+        return "UNKOWN";
+    }
+
+    // the compile-time layout of a pixel type, `C` channels of `Channel` back to back with alpha (if any) last.
+    // `BGR` pixels store the colour channels reversed.
+    template<PixelFmt F, typename Channel, u32 C, bool BGR = false>
+    struct pixel_layout {
+        using Channel_t = Channel;
+
+        static constexpr PixelFmt FORMAT = F;
+
+        // what one channel value is widened to before arithmetic, wide enough for the product of two channels.
+        using Wide_t = std::conditional_t<std::is_floating_point_v<Channel>,
+                                          Channel,
+                                          std::conditional_t<sizeof(Channel) == 1, i32, i64>>;
+
+        static constexpr u32  CHANNELS        = C;
+        static constexpr bool HAS_ALPHA       = C == 2 || C == 4;
+        static constexpr u32  COLOUR_CHANNELS = HAS_ALPHA ? C - 1 : C;
+        static constexpr u32  ALPHA           = HAS_ALPHA ? C - 1 : NO_ALPHA;
+
+        // memory position of logical channel k: r, g, b, a for colour pixels, g, a for grey ones.
+        static constexpr std::array<u32, C> INDEX = [] {
+            std::array<u32, C> index{};
+            for (u32 k = 0; k < C; ++k) {
+                index[k] = (BGR && k < 3) ? 2 - k : k;
+            }
+            return index;
+        }();
+
+        // full scale, float pixels are nominally [0, 1] but aren't clamped to it.
+        static constexpr Channel_t MAX
+            = std::is_floating_point_v<Channel> ? Channel_t{1} : std::numeric_limits<Channel>::max();
+    };
+
+    template<typename P>
+    struct pixel_traits;
+
+    // clang-format off
+    template<> struct pixel_traits<struct GREY8>   : pixel_layout<PF_GREY8,   u8, 1> {};
+    template<> struct pixel_traits<struct GREYa8>  : pixel_layout<PF_GREYa8,  u8, 2> {};
+    template<> struct pixel_traits<struct RGB8>    : pixel_layout<PF_RGB8,    u8, 3> {};
+    template<> struct pixel_traits<struct RGBa8>   : pixel_layout<PF_RGBa8,   u8, 4> {};
+    template<> struct pixel_traits<struct BGR8>    : pixel_layout<PF_BGR8,    u8, 3, true> {};
+    template<> struct pixel_traits<struct BGRa8>   : pixel_layout<PF_BGRa8,   u8, 4, true> {};
+    template<> struct pixel_traits<struct GREY16>  : pixel_layout<PF_GREY16,  u16, 1> {};
+    template<> struct pixel_traits<struct GREYa16> : pixel_layout<PF_GREYa16, u16, 2> {};
+    template<> struct pixel_traits<struct RGB16>   : pixel_layout<PF_RGB16,   u16, 3> {};
+    template<> struct pixel_traits<struct RGBa16>  : pixel_layout<PF_RGBa16,  u16, 4> {};
+    template<> struct pixel_traits<struct HDR32>   : pixel_layout<PF_HDR32,   float, 3> {};
+    template<> struct pixel_traits<struct HDRa32>  : pixel_layout<PF_HDRa32,  float, 4> {};
+    // clang-format on
+
+    template<typename P>
+    using pixel_channel_t = typename pixel_traits<P>::Channel_t;
+
+    // the channels of a pixel as an array in memory order, pixels are plain structs of `CHANNELS` values.
+    template<typename P>
+        requires is_pixel_type<std::remove_const_t<P>>
+    auto* channelsOf(P& p) {
+        using Channel_t = pixel_channel_t<std::remove_const_t<P>>;
+        if constexpr (std::is_const_v<P>) {
+            return reinterpret_cast<const Channel_t*>(&p);
+        } else {
+            return reinterpret_cast<Channel_t*>(&p);
+        }
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_PIXEL_TRAITS_H
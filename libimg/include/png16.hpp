@@ -0,0 +1,302 @@
+#ifndef LIB_IMG_PNG16_H
+#define LIB_IMG_PNG16_H
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "common.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+// only for `stbi_write_png_compression_level`. stb's png writer takes 8-bit samples only and its deflate isn't part of
+// its public api, so the container and the zlib stream are written below.
+#include "stb_image_write.h"
+
+namespace img::detail {
+
+    // deflate bits go out least significant first.
+    class DeflateBits {
+    public:
+        explicit DeflateBits(std::vector<u8>& out) : m_out(out) {
+        }
+
+        void put(u32 bits, u32 count) {
+            m_bits |= u64{bits} << m_count;
+            m_count += count;
+            while (m_count >= 8) {
+                m_out.push_back(static_cast<u8>(m_bits));
+                m_bits >>= 8;
+                m_count -= 8;
+            }
+        }
+
+        // huffman codes are defined most significant bit first.
+        void putCode(u32 code, u32 count) {
+            u32 reversed = 0;
+            for (u32 i = 0; i < count; ++i) {
+                reversed |= ((code >> i) & 1) << (count - 1 - i);
+            }
+            put(reversed, count);
+        }
+
+        void flush() {
+            if (m_count) {
+                put(0, 8 - m_count);
+            }
+        }
+
+    private:
+        std::vector<u8>& m_out;
+        u64              m_bits  = 0;
+        u32              m_count = 0;
+    };
+
+    // literal/length symbol `v` with the fixed huffman code of rfc 1951 3.2.6.
+    inline void putFixedSymbol(DeflateBits& bits, u32 v) {
+        if (v < 144) {
+            bits.putCode(0x30 + v, 8);
+        } else if (v < 256) {
+            bits.putCode(0x190 + v - 144, 9);
+        } else if (v < 280) {
+            bits.putCode(v - 256, 7);
+        } else {
+            bits.putCode(0xC0 + v - 280, 8);
+        }
+    }
+
+    inline void putMatch(DeflateBits& bits, u32 length, u32 distance) {
+        constexpr u16 LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                         31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr u8  LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                          2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr u16 DISTANCE_BASE[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                           33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                           1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+        u32 l = 0;
+        while (l + 1 < 29 && LENGTH_BASE[l + 1] <= length) {
+            ++l;
+        }
+        putFixedSymbol(bits, 257 + l);
+        bits.put(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+        u32 d = 0;
+        while (d + 1 < 30 && DISTANCE_BASE[d + 1] <= distance) {
+            ++d;
+        }
+        bits.putCode(d, 5);
+        bits.put(distance - DISTANCE_BASE[d], d < 4 ? 0 : d / 2 - 1);
+    }
+
+    // a zlib stream of `data` in one fixed huffman block, lz77 over a 32k window with hash chains `quality * 4`
+    // candidates deep, the same trade stb's png writer makes at its compression levels.
+    inline void zlibCompress(const u8* data, std::size_t n, int quality, std::vector<u8>& out) {
+        constexpr u32 WINDOW    = 1u << 15;
+        constexpr u32 MIN_MATCH = 3;
+        constexpr u32 MAX_MATCH = 258;
+
+        const u32 maxChain = static_cast<u32>(std::max(quality, 5)) * 4;
+
+        out.insert(out.end(), {0x78, 0x5E});
+        DeflateBits bits{out};
+        bits.put(1, 1); // final block
+        bits.put(1, 2); // fixed huffman codes
+
+        // the most recent position of every 3-byte hash, and for every position in the window the one before it.
+        std::vector<i64> head(WINDOW, -1), prev(WINDOW, -1);
+
+        auto hash = [&](std::size_t i) {
+            const u32 v = u32{data[i]} << 16 | u32{data[i + 1]} << 8 | data[i + 2];
+            return (v * 2654435761u) >> 17;
+        };
+        auto insert = [&](std::size_t i) {
+            if (i + MIN_MATCH <= n) {
+                const u32 h            = hash(i);
+                prev[i & (WINDOW - 1)] = head[h];
+                head[h]                = static_cast<i64>(i);
+            }
+        };
+
+        std::size_t i = 0;
+        while (i < n) {
+            u32 bestLength = 0, bestDistance = 0;
+            if (i + MIN_MATCH <= n) {
+                const u32 limit = static_cast<u32>(std::min<std::size_t>(MAX_MATCH, n - i));
+                i64       cand  = head[hash(i)];
+                // distances stay below the window, so every candidate's chain slot is still its own.
+                for (u32 chain = 0; cand >= 0 && i - static_cast<std::size_t>(cand) < WINDOW && chain < maxChain;
+                     ++chain) {
+                    const u8* a = data + cand;
+                    const u8* b = data + i;
+                    u32       l = 0;
+                    while (l < limit && a[l] == b[l]) {
+                        ++l;
+                    }
+                    if (l > bestLength) {
+                        bestLength   = l;
+                        bestDistance = static_cast<u32>(i - static_cast<std::size_t>(cand));
+                        if (l == limit) {
+                            break;
+                        }
+                    }
+                    cand = prev[static_cast<std::size_t>(cand) & (WINDOW - 1)];
+                }
+            }
+
+            if (bestLength >= MIN_MATCH) {
+                putMatch(bits, bestLength, bestDistance);
+                for (u32 k = 0; k < bestLength; ++k) {
+                    insert(i + k);
+                }
+                i += bestLength;
+            } else {
+                putFixedSymbol(bits, data[i]);
+                insert(i);
+                ++i;
+            }
+        }
+        putFixedSymbol(bits, 256);
+        bits.flush();
+
+        u32 s1 = 1, s2 = 0;
+        for (std::size_t k = 0; k < n; ++k) {
+            s1 = (s1 + data[k]) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+        out.push_back(static_cast<u8>(s2 >> 8));
+        out.push_back(static_cast<u8>(s2));
+        out.push_back(static_cast<u8>(s1 >> 8));
+        out.push_back(static_cast<u8>(s1));
+    }
+
+    constexpr std::array<u32, 256> PNG_CRC_TABLE = [] {
+        std::array<u32, 256> table{};
+        for (u32 n = 0; n < 256; ++n) {
+            u32 c = n;
+            for (u32 k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    inline void putBigEndian(std::vector<u8>& out, u32 v) {
+        for (i32 shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<u8>(v >> shift));
+        }
+    }
+
+    // length, type, data and the crc of type + data.
+    inline void pngChunk(std::vector<u8>& out, const char* type, const u8* data, std::size_t n) {
+        putBigEndian(out, static_cast<u32>(n));
+        const std::size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data, data + n);
+
+        u32 crc = 0xFFFFFFFFu;
+        for (std::size_t i = start; i < out.size(); ++i) {
+            crc = PNG_CRC_TABLE[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+        }
+        putBigEndian(out, crc ^ 0xFFFFFFFFu);
+    }
+
+    // png samples are big endian.
+    inline void bigEndianSamples(const u16* src, u8* dst, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            dst[2 * i]     = static_cast<u8>(src[i] >> 8);
+            dst[2 * i + 1] = static_cast<u8>(src[i]);
+        }
+    }
+
+    inline u8 paeth(i32 a, i32 b, i32 c) {
+        const i32 p  = a + b - c;
+        const i32 pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) {
+            return static_cast<u8>(a);
+        }
+        return static_cast<u8>(pb <= pc ? b : c);
+    }
+
+    // png filter `type` (0 none, 1 sub, 2 up, 3 average, 4 paeth) of one row, `bpp` bytes per pixel.
+    inline void pngFilterRow(const u8* row, const u8* prev, std::size_t n, u32 bpp, u32 type, u8* out) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const i32 a = i >= bpp ? row[i - bpp] : 0;
+            const i32 b = prev[i];
+            const i32 c = i >= bpp ? prev[i - bpp] : 0;
+            switch (type) {
+                case 0: out[i] = row[i]; break;
+                case 1: out[i] = static_cast<u8>(row[i] - a); break;
+                case 2: out[i] = static_cast<u8>(row[i] - b); break;
+                case 3: out[i] = static_cast<u8>(row[i] - ((a + b) >> 1)); break;
+                default: out[i] = static_cast<u8>(row[i] - paeth(a, b, c)); break;
+            }
+        }
+    }
+
+    // `channels` (1 grey, 2 grey + alpha, 3 rgb, 4 rgba) 16-bit samples per pixel -> a complete png file appended to
+    // `out`. every row takes the filter with the smallest sum of absolute residuals like stb's 8-bit writer, rows
+    // are filtered in parallel and compressed by `zlibCompress()` at `stbi_write_png_compression_level`.
+    inline bool encodePng16(const u16* px, u32 width, u32 height, u32 channels, std::vector<u8>& out) {
+        constexpr u8 COLOR_TYPES[5] = {0, 0, 4, 2, 6};
+
+        const std::size_t rowSamples = std::size_t{width} * channels;
+        const std::size_t rowBytes   = rowSamples * 2;
+        const std::size_t filtered   = (rowBytes + 1) * height;
+        if (channels < 1 || channels > 4 || filtered > INT_MAX) {
+            return false;
+        }
+
+        std::vector<u8> rows(filtered);
+        parallelFor(0, height, 16, [&](u32 y0, u32 y1) {
+            std::vector<u8> cur(rowBytes), prev(rowBytes, 0), trial(rowBytes);
+            if (y0 > 0) {
+                bigEndianSamples(px + (y0 - 1) * rowSamples, prev.data(), rowSamples);
+            }
+
+            for (u32 y = y0; y < y1; ++y) {
+                bigEndianSamples(px + y * rowSamples, cur.data(), rowSamples);
+
+                u8*         dst       = rows.data() + y * (rowBytes + 1);
+                std::size_t bestScore = SIZE_MAX;
+                for (u32 type = 0; type < 5; ++type) {
+                    pngFilterRow(cur.data(), prev.data(), rowBytes, channels * 2, type, trial.data());
+                    std::size_t score = 0;
+                    for (u8 v : trial) {
+                        score += static_cast<std::size_t>(std::abs(static_cast<i8>(v)));
+                    }
+                    if (score < bestScore) {
+                        bestScore = score;
+                        dst[0]    = static_cast<u8>(type);
+                        std::memcpy(dst + 1, trial.data(), rowBytes);
+                    }
+                }
+                cur.swap(prev);
+            }
+        });
+
+        std::vector<u8> zlib;
+        zlibCompress(rows.data(), filtered, stbi_write_png_compression_level, zlib);
+
+        constexpr u8 SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        out.insert(out.end(), SIGNATURE, SIGNATURE + 8);
+
+        // width, height, bit depth, colour type, then default compression, filtering and no interlace.
+        std::vector<u8> header;
+        putBigEndian(header, width);
+        putBigEndian(header, height);
+        header.insert(header.end(), {16, COLOR_TYPES[channels], 0, 0, 0});
+        pngChunk(out, "IHDR", header.data(), header.size());
+        pngChunk(out, "IDAT", zlib.data(), zlib.size());
+        pngChunk(out, "IEND", nullptr, 0);
+
+        return true;
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_PNG16_H
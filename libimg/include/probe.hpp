@@ -0,0 +1,107 @@
+#ifndef LIB_IMG_PROBE_H
+#define LIB_IMG_PROBE_H
+
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "common.hpp"
+#include "format.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+#include "stb_image.h"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    struct ImageInfo {
+        u32      width;
+        u32      height;
+        u32      channelCount;
+        ImageFmt format;
+        u32      bitDepth;
+    };
+
+    namespace detail {
+        inline u32 probeBitDepth(ImageFmt fmt, bool is16Bit) {
+            if (fmt == IF_HDR) {
+                return 32;
+            }
+            return is16Bit ? 16 : 8;
+        }
+    } // namespace detail
+
+    // reads only the image header, no pixel data is decoded.
+    [[nodiscard]] inline std::optional<ImageInfo> probe(std::span<const u8> data) {
+        const int len = static_cast<int>(std::min<std::size_t>(data.size(), INT_MAX));
+
+        int w, h, c;
+        if (!stbi_info_from_memory(data.data(), len, &w, &h, &c)) {
+            return std::nullopt;
+        }
+
+        ImageFmt fmt = detectImageFormat(data);
+        if (fmt == IF_UNKOWN) {
+            fmt = IF_TGA;
+        }
+
+        return ImageInfo{
+            .width        = static_cast<u32>(w),
+            .height       = static_cast<u32>(h),
+            .channelCount = static_cast<u32>(c),
+            .format       = fmt,
+            .bitDepth     = detail::probeBitDepth(fmt, stbi_is_16_bit_from_memory(data.data(), len)),
+        };
+    }
+
+    [[nodiscard]] inline std::optional<ImageInfo> probe(const fs::path& filePath) {
+        FILE* f = fopen(filePath.c_str(), "rb");
+        if (!f) {
+            return std::nullopt;
+        }
+
+        u8         head[IMAGE_SIGNATURE_SIZE];
+        const auto headSize = fread(head, 1, sizeof(head), f);
+        fseek(f, 0, SEEK_SET);
+
+        int                      w, h, c;
+        std::optional<ImageInfo> info;
+        if (stbi_info_from_file(f, &w, &h, &c)) {
+            ImageFmt fmt = detectImageFormat({head, headSize});
+            if (fmt == IF_UNKOWN) {
+                fmt = IF_TGA;
+            }
+
+            info = ImageInfo{
+                .width        = static_cast<u32>(w),
+                .height       = static_cast<u32>(h),
+                .channelCount = static_cast<u32>(c),
+                .format       = fmt,
+                .bitDepth     = detail::probeBitDepth(fmt, stbi_is_16_bit_from_file(f)),
+            };
+        }
+
+        fclose(f);
+        return info;
+    }
+
+    // probes a whole catalogue on the shared thread pool, results are in the same order as `filePaths`.
+    [[nodiscard]] inline std::vector<std::optional<ImageInfo>> probeAll(std::span<const fs::path> filePaths) {
+        std::vector<std::optional<ImageInfo>> infos(filePaths.size());
+
+        parallelFor(0, static_cast<u32>(filePaths.size()), 64, [&filePaths, &infos](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                infos[i] = probe(filePaths[i]);
+            }
+        });
+
+        return infos;
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_PROBE_H
@@ -0,0 +1,561 @@
+#ifndef LIB_IMG_PYRAMID_H
+#define LIB_IMG_PYRAMID_H
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "border.hpp"
+#include "common.hpp"
+#include "image.hpp"
+#include "img_assert.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    namespace detail {
+
+        // levels halve (rounding up) with the binomial kernel [1 4 6 4 1] / 16 in both directions, borders are
+        // reflect-101 like most pyramid implementations. channel values are u8, u16 or float, integer column sums
+        // are kept twice as wide, float ones stay float.
+
+        template<typename T>
+        using PyramidAcc
+            = std::conditional_t<std::is_floating_point_v<T>, T, std::conditional_t<sizeof(T) == 1, u16, u32>>;
+
+        // laplacian band values, signed and as wide as the sums.
+        template<typename T>
+        using PyramidBand = typename std::
+            conditional_t<std::is_floating_point_v<T>, std::type_identity<T>, std::make_signed<PyramidAcc<T>>>::type;
+
+        // `sum / 2^shift`, rounded to nearest for integer channels.
+        template<typename T, typename Acc>
+        T pyrNormalize(Acc sum, u32 shift) {
+            if constexpr (std::is_floating_point_v<T>) {
+                return static_cast<T>(sum * (T{1} / static_cast<T>(1u << shift)));
+            } else {
+                return static_cast<T>((static_cast<u32>(sum) + (1u << (shift - 1))) >> shift);
+            }
+        }
+
+        struct PyramidLevel {
+            std::size_t offset; // in channel values from the start of the arena
+            u32         width;
+            u32         height;
+        };
+
+        // lays out up to `levels` levels back to back, stopping early once a level is 1x1. returns the arena
+        // size in channel values.
+        inline std::size_t layoutPyramid(u32 width, u32 height, u32 levels, u32 channels,
+                                         std::vector<PyramidLevel>& out) {
+            out.clear();
+            std::size_t size = 0;
+            for (u32 i = 0; i < levels; ++i) {
+                out.push_back({size, width, height});
+                size += std::size_t{width} * height * channels;
+                if (width == 1 && height == 1) {
+                    break;
+                }
+                width  = (width + 1) / 2;
+                height = (height + 1) / 2;
+            }
+            return size;
+        }
+
+        // per thread scratch rows, grown once and reused, so rebuilding a pyramid every frame doesn't allocate.
+        // `Slot` keeps two rows of one type apart, float pyramids sum in the channel type.
+        template<typename Acc, u32 Slot = 0>
+        Acc* pyramidScratch(std::size_t n) {
+            thread_local std::vector<Acc> scratch;
+            if (scratch.size() < n) {
+                scratch.resize(n);
+            }
+            return scratch.data();
+        }
+
+        // out = r0 + 4 r1 + 6 r2 + 4 r3 + r4, at most 16 times the channel max so it fits the accumulator.
+        template<typename T>
+        void pyrDownColumns(const T* r0, const T* r1, const T* r2, const T* r3, const T* r4, PyramidAcc<T>* out,
+                            std::size_t n) {
+            std::size_t i = 0;
+#if LIB_IMG_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            if constexpr (std::is_same_v<T, u8>) {
+                auto load = [zero](const u8* p) {
+                    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+                };
+                for (; i + 8 <= n; i += 8) {
+                    const __m128i outer = _mm_add_epi16(load(r0 + i), load(r4 + i));
+                    const __m128i inner = _mm_slli_epi16(_mm_add_epi16(load(r1 + i), load(r3 + i)), 2);
+                    const __m128i mid   = _mm_mullo_epi16(load(r2 + i), _mm_set1_epi16(6));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                     _mm_add_epi16(_mm_add_epi16(outer, inner), mid));
+                }
+            } else if constexpr (std::is_same_v<T, u16>) {
+                // 4 values widened to 32 bits per vector, 6x is 4x + 2x since sse2 has no 32-bit multiply.
+                auto load = [zero](const u16* p) {
+                    return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+                };
+                for (; i + 4 <= n; i += 4) {
+                    const __m128i outer = _mm_add_epi32(load(r0 + i), load(r4 + i));
+                    const __m128i inner = _mm_slli_epi32(_mm_add_epi32(load(r1 + i), load(r3 + i)), 2);
+                    const __m128i m     = load(r2 + i);
+                    const __m128i mid   = _mm_add_epi32(_mm_slli_epi32(m, 2), _mm_slli_epi32(m, 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                     _mm_add_epi32(_mm_add_epi32(outer, inner), mid));
+                }
+            } else {
+                const __m128 four = _mm_set1_ps(4), six = _mm_set1_ps(6);
+                for (; i + 4 <= n; i += 4) {
+                    const __m128 outer = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r4 + i));
+                    const __m128 inner = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r1 + i), _mm_loadu_ps(r3 + i)), four);
+                    const __m128 mid   = _mm_mul_ps(_mm_loadu_ps(r2 + i), six);
+                    _mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(outer, inner), mid));
+                }
+            }
+#endif
+            for (; i < n; ++i) {
+                out[i] = static_cast<PyramidAcc<T>>(r0[i] + 4 * (r1[i] + r3[i]) + 6 * r2[i] + r4[i]);
+            }
+        }
+
+        // even output rows: r0 + 6 r1 + r2, odd ones: 4 r1 + 4 r2, both sum to 8.
+        template<typename T>
+        void pyrUpColumns(const T* r0, const T* r1, const T* r2, bool odd, PyramidAcc<T>* out, std::size_t n) {
+            std::size_t i = 0;
+#if LIB_IMG_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            if constexpr (std::is_same_v<T, u8>) {
+                auto load = [zero](const u8* p) {
+                    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+                };
+                for (; i + 8 <= n; i += 8) {
+                    const __m128i v
+                        = odd ? _mm_slli_epi16(_mm_add_epi16(load(r1 + i), load(r2 + i)), 2)
+                              : _mm_add_epi16(_mm_add_epi16(load(r0 + i), load(r2 + i)),
+                                              _mm_mullo_epi16(load(r1 + i), _mm_set1_epi16(6)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+                }
+            } else if constexpr (std::is_same_v<T, u16>) {
+                auto load = [zero](const u16* p) {
+                    return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+                };
+                for (; i + 4 <= n; i += 4) {
+                    const __m128i m = load(r1 + i);
+                    const __m128i v
+                        = odd ? _mm_slli_epi32(_mm_add_epi32(m, load(r2 + i)), 2)
+                              : _mm_add_epi32(_mm_add_epi32(load(r0 + i), load(r2 + i)),
+                                              _mm_add_epi32(_mm_slli_epi32(m, 2), _mm_slli_epi32(m, 1)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+                }
+            } else {
+                for (; i + 4 <= n; i += 4) {
+                    const __m128 m = _mm_loadu_ps(r1 + i);
+                    const __m128 v
+                        = odd ? _mm_mul_ps(_mm_add_ps(m, _mm_loadu_ps(r2 + i)), _mm_set1_ps(4))
+                              : _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r2 + i)),
+                                           _mm_mul_ps(m, _mm_set1_ps(6)));
+                    _mm_storeu_ps(out + i, v);
+                }
+            }
+#endif
+            for (; i < n; ++i) {
+                out[i] = static_cast<PyramidAcc<T>>(odd ? 4 * (r1[i] + r2[i]) : r0[i] + 6 * r1[i] + r2[i]);
+            }
+        }
+
+        // pads a row of `width` pixels stored at `row + pad * channels` with `pad` reflect-101 pixels per side.
+        template<typename Acc>
+        void padReflect101(Acc* row, u32 width, u32 channels, u32 pad) {
+            extendRow(reinterpret_cast<u8*>(row), width, channels * sizeof(Acc), pad, pad, BM_REFLECT_101, nullptr);
+        }
+
+        // out[i] = (c[i - 2 step] + 4 c[i - step] + 6 c[i] + 4 c[i + step] + c[i + 2 step]) / 256 at every column
+        // of a padded row of column sums. integer sums stay below 16 * 16 times the channel max, which fits the
+        // accumulator, so the vector paths round and narrow in it directly.
+        template<typename T>
+        void pyrDownRow(const PyramidAcc<T>* c, std::ptrdiff_t step, T* out, std::size_t n) {
+            std::size_t i = 0;
+#if LIB_IMG_SSE2
+            if constexpr (std::is_same_v<T, u8>) {
+                auto load = [](const u16* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+                const __m128i round = _mm_set1_epi16(128);
+                for (; i + 8 <= n; i += 8) {
+                    const u16*    p     = c + i;
+                    const __m128i outer = _mm_add_epi16(load(p - 2 * step), load(p + 2 * step));
+                    const __m128i inner = _mm_slli_epi16(_mm_add_epi16(load(p - step), load(p + step)), 2);
+                    const __m128i mid   = _mm_mullo_epi16(load(p), _mm_set1_epi16(6));
+                    const __m128i sum   = _mm_add_epi16(_mm_add_epi16(outer, inner), mid);
+                    const __m128i v     = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, v));
+                }
+            } else if constexpr (std::is_same_v<T, u16>) {
+                auto load = [](const u32* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+                // sse2 only packs signed, so the values are biased into i16 range and back.
+                const __m128i bias32 = _mm_set1_epi32(0x8000);
+                const __m128i bias16 = _mm_set1_epi16(static_cast<i16>(0x8000));
+                const __m128i round  = _mm_set1_epi32(128);
+                for (; i + 4 <= n; i += 4) {
+                    const u32*    p     = c + i;
+                    const __m128i outer = _mm_add_epi32(load(p - 2 * step), load(p + 2 * step));
+                    const __m128i inner = _mm_slli_epi32(_mm_add_epi32(load(p - step), load(p + step)), 2);
+                    const __m128i m     = load(p);
+                    const __m128i mid   = _mm_add_epi32(_mm_slli_epi32(m, 2), _mm_slli_epi32(m, 1));
+                    const __m128i sum   = _mm_add_epi32(_mm_add_epi32(outer, inner), mid);
+                    const __m128i v     = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(sum, round), 8), bias32);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(_mm_packs_epi32(v, v), bias16));
+                }
+            } else {
+                const __m128 four = _mm_set1_ps(4), six = _mm_set1_ps(6), scale = _mm_set1_ps(1.0f / 256);
+                for (; i + 4 <= n; i += 4) {
+                    const float* p     = c + i;
+                    const __m128 outer = _mm_add_ps(_mm_loadu_ps(p - 2 * step), _mm_loadu_ps(p + 2 * step));
+                    const __m128 inner = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p - step), _mm_loadu_ps(p + step)), four);
+                    const __m128 mid   = _mm_mul_ps(_mm_loadu_ps(p), six);
+                    const __m128 sum   = _mm_add_ps(_mm_add_ps(outer, inner), mid);
+                    _mm_storeu_ps(out + i, _mm_mul_ps(sum, scale));
+                }
+            }
+#endif
+            for (; i < n; ++i) {
+                const PyramidAcc<T>* p   = c + i;
+                const auto           sum = p[-2 * step] + 4 * (p[-step] + p[step]) + 6 * p[0] + p[2 * step];
+                out[i]                   = pyrNormalize<T>(sum, 8);
+            }
+        }
+
+        // out pixel x = in pixel 2x, `C` channel values per pixel.
+        template<u32 C, typename T>
+        void decimateRow(const T* in, T* out, u32 width) {
+            for (u32 x = 0; x < width; ++x) {
+                for (u32 ch = 0; ch < C; ++ch) {
+                    out[std::size_t{x} * C + ch] = in[std::size_t{2 * x} * C + ch];
+                }
+            }
+        }
+
+        template<typename T>
+        void decimateRow(const T* in, T* out, u32 width, u32 channels) {
+            switch (channels) {
+                case 1: decimateRow<1>(in, out, width); break;
+                case 2: decimateRow<2>(in, out, width); break;
+                case 3: decimateRow<3>(in, out, width); break;
+                case 4: decimateRow<4>(in, out, width); break;
+                default: IMG_ABORT("unsupported channel count: %u", channels);
+            }
+        }
+
+        // one fused blur-and-decimate pass per output row: a vertical 5-tap over five source rows, then the
+        // horizontal 5-tap along the whole row, vectorised, of which every other pixel is kept.
+        template<typename T>
+        void pyrDown(const T* src, u32 srcWidth, u32 srcHeight, T* dst, u32 dstWidth, u32 dstHeight, u32 channels) {
+            using Acc                = PyramidAcc<T>;
+            const std::size_t srcRow = std::size_t{srcWidth} * channels;
+
+            parallelFor(0, dstHeight, 16, [&](u32 y0, u32 y1) {
+                Acc* cols    = pyramidScratch<Acc>((std::size_t{srcWidth} + 4) * channels);
+                Acc* mid     = cols + 2 * channels;
+                T*   blurred = pyramidScratch<T, 1>(srcRow);
+
+                for (u32 y = y0; y < y1; ++y) {
+                    const T* r[5];
+                    for (i64 k = 0; k < 5; ++k) {
+                        r[k] = src + borderIndex(2 * i64{y} + k - 2, srcHeight, BM_REFLECT_101) * srcRow;
+                    }
+                    pyrDownColumns(r[0], r[1], r[2], r[3], r[4], mid, srcRow);
+                    padReflect101(cols, srcWidth, channels, 2);
+                    pyrDownRow<T>(mid, channels, blurred, srcRow);
+
+                    decimateRow(blurred, dst + std::size_t{y} * dstWidth * channels, dstWidth, channels);
+                }
+            });
+        }
+
+        // row `y` of the 2x upsampled, [1 4 6 4 1] / 8 interpolated coarse level, `width` may be one short of twice
+        // the coarse width when the finer level has odd size.
+        template<typename T>
+        void pyrUpRow(const T* coarse, u32 coarseWidth, u32 coarseHeight, u32 channels, u32 y, T* out, u32 width) {
+            using Acc                = PyramidAcc<T>;
+            const std::size_t rowLen = std::size_t{coarseWidth} * channels;
+            const i64         i      = y / 2;
+            const bool        odd    = y % 2;
+
+            const T* r0 = coarse + borderIndex(i - 1, coarseHeight, BM_REFLECT_101) * rowLen;
+            const T* r1 = coarse + i * rowLen;
+            const T* r2 = coarse + borderIndex(i + 1, coarseHeight, BM_REFLECT_101) * rowLen;
+
+            Acc* cols = pyramidScratch<Acc>((std::size_t{coarseWidth} + 2) * channels);
+            Acc* mid  = cols + channels;
+            pyrUpColumns(r0, r1, r2, odd, mid, rowLen);
+            padReflect101(cols, coarseWidth, channels, 1);
+
+            // each coarse column yields an even (1 6 1) and an odd (4 4) output column.
+            const std::ptrdiff_t step = channels;
+            for (u32 j = 0; 2 * j < width; ++j) {
+                const Acc* c    = mid + std::size_t{j} * channels;
+                T*         even = out + std::size_t{2 * j} * channels;
+                for (u32 ch = 0; ch < channels; ++ch) {
+                    even[ch] = pyrNormalize<T>(c[ch - step] + 6 * c[ch] + c[ch + step], 6);
+                }
+                if (2 * j + 1 < width) {
+                    for (u32 ch = 0; ch < channels; ++ch) {
+                        even[ch + step] = pyrNormalize<T>(4 * (c[ch] + c[ch + step]), 6);
+                    }
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // every level of a gaussian pyramid in one contiguous buffer, level 0 is a copy of the source. `build()`
+    // reuses the buffer when the size and level count don't grow.
+    template<typename Pixel>
+        requires(is_color_8_bit_depth<Pixel> || is_color_16_bit_depth<Pixel> || is_hdr_pixel<Pixel>)
+    class LIB_IMG_PUBLIC GaussianPyramid {
+    public:
+        // one colour channel value, u8, u16 or float.
+        using Channel_t = pixel_channel_t<Pixel>;
+
+        GaussianPyramid() = default;
+
+        void build(const Image<Pixel>& image, u32 levels) {
+            IMG_OP_SCOPE("gaussianPyramid", image);
+            IMG_ASSERT(levels > 0, "a pyramid needs at least one level");
+            IMG_ASSERT(!image.isNull(), "can't build a pyramid from a null image");
+
+            const u32 c = channelCountFromPixelType<Pixel>();
+            m_arena.resize(detail::layoutPyramid(image.width(), image.height(), levels, c, m_levels));
+
+            const Channel_t* src = reinterpret_cast<const Channel_t*>(image.begin());
+            std::copy(src, src + std::size_t{image.pixelCount()} * c, m_arena.data());
+            for (u32 i = 1; i < m_levels.size(); ++i) {
+                const detail::PyramidLevel& fine   = m_levels[i - 1];
+                const detail::PyramidLevel& coarse = m_levels[i];
+                detail::pyrDown(m_arena.data() + fine.offset,
+                                fine.width,
+                                fine.height,
+                                m_arena.data() + coarse.offset,
+                                coarse.width,
+                                coarse.height,
+                                c);
+            }
+        }
+
+        // can be fewer than requested if the image reaches 1x1 first.
+        u32 levels() const {
+            return static_cast<u32>(m_levels.size());
+        }
+
+        u32 width(u32 level) const {
+            return m_levels[level].width;
+        }
+
+        u32 height(u32 level) const {
+            return m_levels[level].height;
+        }
+
+        // row-major pixels of `level`, valid until the next `build()`.
+        std::span<const Pixel> level(u32 level) const {
+            const detail::PyramidLevel& l = m_levels[level];
+            return {reinterpret_cast<const Pixel*>(m_arena.data() + l.offset), std::size_t{l.width} * l.height};
+        }
+
+        [[nodiscard]] Image<Pixel> levelImage(u32 level) const {
+            Image<Pixel> out{width(level), height(level)};
+            if (!out.isNull()) {
+                std::ranges::copy(this->level(level), out.begin());
+            }
+            return out;
+        }
+
+        const u8* levelBytes(u32 level) const {
+            return reinterpret_cast<const u8*>(levelData(level));
+        }
+
+        u8* levelBytes(u32 level) {
+            return reinterpret_cast<u8*>(levelData(level));
+        }
+
+        // the interleaved channel values of `level`.
+        const Channel_t* levelData(u32 level) const {
+            return m_arena.data() + m_levels[level].offset;
+        }
+
+        Channel_t* levelData(u32 level) {
+            return m_arena.data() + m_levels[level].offset;
+        }
+
+    private:
+        std::vector<Channel_t>            m_arena;
+        std::vector<detail::PyramidLevel> m_levels;
+    };
+
+    // band-pass levels `G(i) - expand(G(i + 1))` as signed channel values twice the pixel's width (i16 for 8-bit
+    // pixels, i32 for 16-bit ones, float for hdr ones), the last level holds the coarsest gaussian level as is.
+    // `collapse()` reproduces integer sources exactly and hdr ones to float rounding.
+    template<typename Pixel>
+        requires(is_color_8_bit_depth<Pixel> || is_color_16_bit_depth<Pixel> || is_hdr_pixel<Pixel>)
+    class LIB_IMG_PUBLIC LaplacianPyramid {
+    public:
+        using Channel_t = typename GaussianPyramid<Pixel>::Channel_t;
+        using Band_t    = detail::PyramidBand<Channel_t>;
+
+        LaplacianPyramid() = default;
+
+        void build(const Image<Pixel>& image, u32 levels) {
+            IMG_OP_SCOPE("laplacianPyramid", image);
+            m_gaussian.build(image, levels);
+
+            const u32 c = channelCountFromPixelType<Pixel>();
+            m_arena.resize(detail::layoutPyramid(image.width(), image.height(), levels, c, m_levels));
+
+            const u32 last = this->levels() - 1;
+            for (u32 i = 0; i < last; ++i) {
+                const detail::PyramidLevel& fine   = m_levels[i];
+                const detail::PyramidLevel& coarse = m_levels[i + 1];
+                const Channel_t*            g      = m_gaussian.levelData(i);
+                const Channel_t*            up     = m_gaussian.levelData(i + 1);
+                const std::size_t           rowLen = std::size_t{fine.width} * c;
+
+                parallelFor(0, fine.height, 16, [&](u32 y0, u32 y1) {
+                    std::vector<Channel_t>& expanded = expandScratch(rowLen);
+                    for (u32 y = y0; y < y1; ++y) {
+                        detail::pyrUpRow(up, coarse.width, coarse.height, c, y, expanded.data(), fine.width);
+
+                        const Channel_t* in  = g + y * rowLen;
+                        Band_t*          out = m_arena.data() + fine.offset + y * rowLen;
+                        for (std::size_t e = 0; e < rowLen; ++e) {
+                            out[e] = static_cast<Band_t>(Band_t{in[e]} - Band_t{expanded[e]});
+                        }
+                    }
+                });
+            }
+
+            const Channel_t* top = m_gaussian.levelData(last);
+            std::copy(top, top + std::size_t{width(last)} * height(last) * c, m_arena.data() + m_levels[last].offset);
+        }
+
+        u32 levels() const {
+            return static_cast<u32>(m_levels.size());
+        }
+
+        u32 width(u32 level) const {
+            return m_levels[level].width;
+        }
+
+        u32 height(u32 level) const {
+            return m_levels[level].height;
+        }
+
+        // interleaved channel values of `level`, modify them (e.g. to blend two pyramids) before collapsing.
+        std::span<Band_t> level(u32 level) {
+            const detail::PyramidLevel& l = m_levels[level];
+            return {m_arena.data() + l.offset, std::size_t{l.width} * l.height * channelCountFromPixelType<Pixel>()};
+        }
+
+        std::span<const Band_t> level(u32 level) const {
+            const detail::PyramidLevel& l = m_levels[level];
+            return {m_arena.data() + l.offset, std::size_t{l.width} * l.height * channelCountFromPixelType<Pixel>()};
+        }
+
+        // reconstructs the full resolution image into `out`, which is only reallocated if its size differs. the
+        // gaussian levels kept from `build()` are overwritten on the way, coarse to fine, so nothing is allocated.
+        void collapse(Image<Pixel>& out) {
+            IMG_OP_SCOPE("collapsePyramid", out);
+            IMG_ASSERT(!m_levels.empty(), "collapsing an empty pyramid");
+
+            const u32 c    = channelCountFromPixelType<Pixel>();
+            const u32 last = levels() - 1;
+
+            Channel_t* top = m_gaussian.levelData(last);
+            for (std::size_t e = m_levels[last].offset; e < m_arena.size(); ++e) {
+                top[e - m_levels[last].offset] = toChannel(m_arena[e]);
+            }
+
+            for (u32 i = last; i-- > 0;) {
+                const detail::PyramidLevel& fine   = m_levels[i];
+                const detail::PyramidLevel& coarse = m_levels[i + 1];
+                const std::size_t           rowLen = std::size_t{fine.width} * c;
+
+                parallelFor(0, fine.height, 16, [&](u32 y0, u32 y1) {
+                    std::vector<Channel_t>& expanded = expandScratch(rowLen);
+                    for (u32 y = y0; y < y1; ++y) {
+                        detail::pyrUpRow(m_gaussian.levelData(i + 1),
+                                         coarse.width,
+                                         coarse.height,
+                                         c,
+                                         y,
+                                         expanded.data(),
+                                         fine.width);
+
+                        const Band_t* band = m_arena.data() + fine.offset + y * rowLen;
+                        Channel_t*    dst  = m_gaussian.levelData(i) + y * rowLen;
+                        for (std::size_t e = 0; e < rowLen; ++e) {
+                            dst[e] = toChannel(band[e] + expanded[e]);
+                        }
+                    }
+                });
+            }
+
+            if (out.isNull() || out.width() != width(0) || out.height() != height(0)) {
+                out = Image<Pixel>{width(0), height(0)};
+            }
+            std::ranges::copy(m_gaussian.level(0), out.begin());
+        }
+
+        [[nodiscard]] Image<Pixel> collapse() {
+            Image<Pixel> out;
+            collapse(out);
+            return out;
+        }
+
+    private:
+        // saturating for integer channels, edited bands can overshoot. float ones are never clamped.
+        static Channel_t toChannel(auto v) {
+            if constexpr (std::is_floating_point_v<Channel_t>) {
+                return v;
+            } else {
+                return static_cast<Channel_t>(std::clamp<i32>(v, 0, std::numeric_limits<Channel_t>::max()));
+            }
+        }
+
+        static std::vector<Channel_t>& expandScratch(std::size_t n) {
+            thread_local std::vector<Channel_t> scratch;
+            if (scratch.size() < n) {
+                scratch.resize(n);
+            }
+            return scratch;
+        }
+
+    private:
+        GaussianPyramid<Pixel>            m_gaussian;
+        std::vector<Band_t>               m_arena;
+        std::vector<detail::PyramidLevel> m_levels;
+    };
+
+    template<typename Pixel>
+        requires(is_color_8_bit_depth<Pixel> || is_color_16_bit_depth<Pixel> || is_hdr_pixel<Pixel>)
+    [[nodiscard]] GaussianPyramid<Pixel> buildGaussianPyramid(const Image<Pixel>& image, u32 levels) {
+        GaussianPyramid<Pixel> pyramid;
+        pyramid.build(image, levels);
+        return pyramid;
+    }
+
+    template<typename Pixel>
+        requires(is_color_8_bit_depth<Pixel> || is_color_16_bit_depth<Pixel> || is_hdr_pixel<Pixel>)
+    [[nodiscard]] LaplacianPyramid<Pixel> buildLaplacianPyramid(const Image<Pixel>& image, u32 levels) {
+        LaplacianPyramid<Pixel> pyramid;
+        pyramid.build(image, levels);
+        return pyramid;
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_PYRAMID_H
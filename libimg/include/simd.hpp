@@ -0,0 +1,292 @@
+#ifndef LIB_IMG_SIMD_H
+#define LIB_IMG_SIMD_H
+
+#include <algorithm>
+#include <cstddef>
+
+#include "common.hpp"
+#include "types.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+// kernels pick the widest instruction set the translation unit is compiled for and keep a scalar tail/fallback,
+// build with `LIB_IMG_NATIVE_ARCH` (or your own `-m` flags) to enable anything past SSE2.
+#if defined(__SSE2__) || defined(_M_X64)
+    #define LIB_IMG_SSE2 1
+#endif
+
+#if defined(__SSSE3__)
+    #define LIB_IMG_SSSE3 1
+#endif
+
+#if defined(__SSE4_1__)
+    #define LIB_IMG_SSE41 1
+#endif
+
+#if defined(__AVX2__)
+    #define LIB_IMG_AVX2 1
+#endif
+
+namespace img::simd {
+
+    struct MinU8 {
+        static u8 scalar(u8 a, u8 b) {
+            return a < b ? a : b;
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_min_epu8(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_min_epu8(a, b);
+        }
+#endif
+    };
+
+    struct MaxU8 {
+        static u8 scalar(u8 a, u8 b) {
+            return a > b ? a : b;
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_max_epu8(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_max_epu8(a, b);
+        }
+#endif
+    };
+
+    struct AddSatU8 {
+        static u8 scalar(u8 a, u8 b) {
+            const u32 s = u32{a} + b;
+            return static_cast<u8>(s > 255 ? 255 : s);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_adds_epu8(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_adds_epu8(a, b);
+        }
+#endif
+    };
+
+    struct SubSatU8 {
+        static u8 scalar(u8 a, u8 b) {
+            return static_cast<u8>(a > b ? a - b : 0);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_subs_epu8(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_subs_epu8(a, b);
+        }
+#endif
+    };
+
+    struct AddSatU16 {
+        static u16 scalar(u16 a, u16 b) {
+            const u32 s = u32{a} + b;
+            return static_cast<u16>(s > 0xFFFF ? 0xFFFF : s);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_adds_epu16(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_adds_epu16(a, b);
+        }
+#endif
+    };
+
+    struct SubSatU16 {
+        static u16 scalar(u16 a, u16 b) {
+            return static_cast<u16>(a > b ? a - b : 0);
+        }
+#if LIB_IMG_SSE2
+        static __m128i sse(__m128i a, __m128i b) {
+            return _mm_subs_epu16(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256i avx(__m256i a, __m256i b) {
+            return _mm256_subs_epu16(a, b);
+        }
+#endif
+    };
+
+    struct AddF32 {
+        static float scalar(float a, float b) {
+            return a + b;
+        }
+#if LIB_IMG_SSE2
+        static __m128 sse(__m128 a, __m128 b) {
+            return _mm_add_ps(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256 avx(__m256 a, __m256 b) {
+            return _mm256_add_ps(a, b);
+        }
+#endif
+    };
+
+    struct SubF32 {
+        static float scalar(float a, float b) {
+            return a - b;
+        }
+#if LIB_IMG_SSE2
+        static __m128 sse(__m128 a, __m128 b) {
+            return _mm_sub_ps(a, b);
+        }
+#endif
+#if LIB_IMG_AVX2
+        static __m256 avx(__m256 a, __m256 b) {
+            return _mm256_sub_ps(a, b);
+        }
+#endif
+    };
+
+    // dst[i] = Op(a[i], b[i]) for `n` bytes, `dst` may alias either input.
+    template<typename Op>
+    void apply(u8* dst, const u8* a, const u8* b, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 32 <= n; i += 32) {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::avx(va, vb));
+        }
+#endif
+#if LIB_IMG_SSE2
+        for (; i + 16 <= n; i += 16) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Op::sse(va, vb));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = Op::scalar(a[i], b[i]);
+        }
+    }
+
+    // dst[i] = Op(a[i], b[i]) for `n` 16-bit values, `dst` may alias either input.
+    template<typename Op>
+    void apply(u16* dst, const u16* a, const u16* b, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 16 <= n; i += 16) {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::avx(va, vb));
+        }
+#endif
+#if LIB_IMG_SSE2
+        for (; i + 8 <= n; i += 8) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Op::sse(va, vb));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = Op::scalar(a[i], b[i]);
+        }
+    }
+
+    // dst[i] = Op(a[i], b[i]) for `n` floats, `dst` may alias either input.
+    template<typename Op>
+    void apply(float* dst, const float* a, const float* b, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(dst + i, Op::avx(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        }
+#endif
+#if LIB_IMG_SSE2
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(dst + i, Op::sse(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = Op::scalar(a[i], b[i]);
+        }
+    }
+
+    // the element-wise add and subtract matching pixel arithmetic on a channel type, saturating for the integer ones.
+    template<typename T>
+    struct ChannelOps;
+
+    template<>
+    struct ChannelOps<u8> {
+        using Add = AddSatU8;
+        using Sub = SubSatU8;
+    };
+
+    template<>
+    struct ChannelOps<u16> {
+        using Add = AddSatU16;
+        using Sub = SubSatU16;
+    };
+
+    template<>
+    struct ChannelOps<float> {
+        using Add = AddF32;
+        using Sub = SubF32;
+    };
+
+    // dst[i] += add[i] - sub[i] on 16-bit counters, the building block of sliding histograms.
+    inline void slideU16(u16* dst, const u16* add, const u16* sub, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_AVX2
+        for (; i + 16 <= n; i += 16) {
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add + i));
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sub_epi16(_mm256_add_epi16(d, a), s));
+        }
+#endif
+#if LIB_IMG_SSE2
+        for (; i + 8 <= n; i += 8) {
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i));
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_sub_epi16(_mm_add_epi16(d, a), s));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = static_cast<u16>(dst[i] + add[i] - sub[i]);
+        }
+    }
+
+    // dst[i] += src[i] on 16-bit counters.
+    inline void addU16(u16* dst, const u16* src, std::size_t n) {
+        std::size_t i = 0;
+#if LIB_IMG_SSE2
+        for (; i + 8 <= n; i += 8) {
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi16(d, a));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = static_cast<u16>(dst[i] + src[i]);
+        }
+    }
+
+} // namespace img::simd
+
+#endif // LIB_IMG_SIMD_H
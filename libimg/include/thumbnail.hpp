@@ -0,0 +1,175 @@
+#ifndef LIB_IMG_THUMBNAIL_H
+#define LIB_IMG_THUMBNAIL_H
+
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "common.hpp"
+#include "image.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
+#include "pixel.hpp"
+#include "types.hpp"
+
+#include "stb_image.h"
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    namespace detail {
+
+        // streaming box downscaler: source rows are pushed one at a time and folded into a single row of
+        // accumulators, so the only state is `dstWidth * channels` sums no matter how large the source is.
+        class BoxDownscaler {
+        public:
+            BoxDownscaler(u32 srcWidth, u32 srcHeight, u32 dstWidth, u32 dstHeight, u32 channels, u8* dst)
+                : m_srcHeight(srcHeight),
+                  m_dstWidth(dstWidth),
+                  m_dstHeight(dstHeight),
+                  m_channels(channels),
+                  m_dst(dst),
+                  m_colBin(srcWidth),
+                  m_colSpan(dstWidth),
+                  m_acc(dstWidth * channels, 0) {
+                for (u32 x = 0; x < srcWidth; ++x) {
+                    m_colBin[x] = static_cast<u32>((u64{x} * dstWidth) / srcWidth);
+                    ++m_colSpan[m_colBin[x]];
+                }
+                m_rowEnd = rowBinEnd(0);
+            }
+
+            void pushRow(const u8* row) {
+                for (u32 x = 0; x < m_colBin.size(); ++x) {
+                    u64* acc = &m_acc[m_colBin[x] * m_channels];
+                    for (u32 c = 0; c < m_channels; ++c) {
+                        acc[c] += row[x * m_channels + c];
+                    }
+                }
+
+                if (++m_srcRow == m_rowEnd) {
+                    flushRow();
+                }
+            }
+
+        private:
+            u32 rowBinEnd(u32 dstRow) const {
+                return static_cast<u32>((u64{dstRow + 1} * m_srcHeight + m_dstHeight - 1) / m_dstHeight);
+            }
+
+            void flushRow() {
+                const u32 rowSpan = m_srcRow - m_rowBegin;
+                u8*       out     = m_dst + u64{m_dstRow} * m_dstWidth * m_channels;
+
+                for (u32 x = 0; x < m_dstWidth; ++x) {
+                    const u64 count = u64{m_colSpan[x]} * rowSpan;
+                    for (u32 c = 0; c < m_channels; ++c) {
+                        u64& acc                = m_acc[x * m_channels + c];
+                        out[x * m_channels + c] = static_cast<u8>((acc + count / 2) / count);
+                        acc                     = 0;
+                    }
+                }
+
+                m_rowBegin = m_srcRow;
+                if (++m_dstRow < m_dstHeight) {
+                    m_rowEnd = rowBinEnd(m_dstRow);
+                }
+            }
+
+        private:
+            u32 m_srcHeight, m_dstWidth, m_dstHeight, m_channels;
+            u8* m_dst;
+
+            u32 m_srcRow = 0, m_rowBegin = 0, m_rowEnd = 0, m_dstRow = 0;
+
+            std::vector<u32> m_colBin;
+            std::vector<u32> m_colSpan;
+            std::vector<u64> m_acc; // a bin of a tiny thumbnail of a large image overflows 32 bits
+        };
+
+        // largest size that fits in `maxWidth * maxHeight` keeping the aspect ratio, never upscales.
+        inline arr2<u32> thumbnailSize(u32 width, u32 height, u32 maxWidth, u32 maxHeight) {
+            if (width <= maxWidth && height <= maxHeight) {
+                return {width, height};
+            }
+
+            if (u64{width} * maxHeight >= u64{height} * maxWidth) {
+                return {maxWidth, std::max(1u, static_cast<u32>((u64{height} * maxWidth + width / 2) / width))};
+            }
+
+            return {std::max(1u, static_cast<u32>((u64{width} * maxHeight + height / 2) / height)), maxHeight};
+        }
+
+    } // namespace detail
+
+    // decodes `filePath` and box-averages it straight into a thumbnail that fits in `maxWidth * maxHeight`,
+    // without materialising a full resolution `Image` first. returns a null image if the file can't be decoded or the
+    // memory budget refuses the decoded source, which is admitted before stb decodes it.
+    template<typename Pixel>
+        requires is_color_8_bit_depth<Pixel>
+    [[nodiscard]] Image<Pixel> loadThumbnail(const fs::path& filePath, u32 maxWidth, u32 maxHeight) {
+        IMG_ASSERT(maxWidth > 0 && maxHeight > 0, "thumbnail bounds must be non zero");
+
+        Image<Pixel> thumb;
+        IMG_OP_SCOPE("loadThumbnail", thumb);
+        const int c = static_cast<int>(channelCountFromPixelType<Pixel>());
+
+        const std::vector<u8> encoded = detail::readFile(filePath);
+        const int             size    = static_cast<int>(encoded.size());
+
+        int w, h, fileChannels;
+        if (!stbi_info_from_memory(encoded.data(), size, &w, &h, &fileChannels)) {
+            return thumb;
+        }
+
+        const u64 decoded = u64{static_cast<u32>(w)} * static_cast<u32>(h) * static_cast<u32>(c);
+        if (!detail::tryChargePixels(decoded, 0, true)) {
+            return thumb;
+        }
+
+        u8* d = stbi_load_from_memory(encoded.data(), size, &w, &h, &fileChannels, c);
+        if (!d) {
+            detail::releasePixels(decoded, 0);
+            return thumb;
+        }
+
+        const u32 srcWidth  = static_cast<u32>(w);
+        const u32 srcHeight = static_cast<u32>(h);
+
+        const auto [dstWidth, dstHeight] = detail::thumbnailSize(srcWidth, srcHeight, maxWidth, maxHeight);
+
+        thumb = Image<Pixel>{dstWidth, dstHeight};
+        detail::BoxDownscaler scaler{
+            srcWidth, srcHeight, dstWidth, dstHeight, static_cast<u32>(c), reinterpret_cast<u8*>(thumb.begin())};
+
+        const u64 stride = u64{srcWidth} * static_cast<u32>(c);
+        for (u32 y = 0; y < srcHeight; ++y) {
+            scaler.pushRow(d + y * stride);
+        }
+
+        stbi_image_free(d);
+        detail::releasePixels(decoded, 0);
+        return thumb;
+    }
+
+    // thumbnails a batch of files in parallel, one file per task, results keep the order of `filePaths`.
+    template<typename Pixel>
+        requires is_color_8_bit_depth<Pixel>
+    [[nodiscard]] std::vector<Image<Pixel>>
+        loadThumbnails(std::span<const fs::path> filePaths, u32 maxWidth, u32 maxHeight) {
+        std::vector<Image<Pixel>> thumbs(filePaths.size());
+
+        parallelFor(0, static_cast<u32>(filePaths.size()), 1, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                thumbs[i] = loadThumbnail<Pixel>(filePaths[i], maxWidth, maxHeight);
+            }
+        });
+
+        return thumbs;
+    }
+
+} // namespace img
+
+#endif // LIB_IMG_THUMBNAIL_H
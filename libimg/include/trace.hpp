@@ -0,0 +1,268 @@
+#ifndef LIB_IMG_TRACE_H
+#define LIB_IMG_TRACE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "pixel_traits.hpp"
+#include "types.hpp"
+
+// records a scoped event for every image operation, loader and saver when 1. when 0 (the default) the
+// instrumentation macros expand to nothing and none of the code below runs.
+#ifndef LIB_IMG_TRACE
+    #define LIB_IMG_TRACE 0
+#endif
+
+// events kept per thread, the oldest are overwritten first. a power of two.
+#ifndef LIB_IMG_TRACE_CAPACITY
+    #define LIB_IMG_TRACE_CAPACITY 16384
+#endif
+
+static_assert((LIB_IMG_TRACE_CAPACITY & (LIB_IMG_TRACE_CAPACITY - 1)) == 0,
+              "`LIB_IMG_TRACE_CAPACITY` must be a power of two");
+
+namespace img {
+
+    namespace fs = std::filesystem;
+
+    struct TraceEvent {
+        const char* name;
+        PixelFmt    format;
+        u32         width;
+        u32         height;
+        u32         thread;
+        u64         bytes; // pixel bytes of the image the operation left behind
+        u64         start; // ns, steady clock
+        u64         duration;
+    };
+
+    namespace detail {
+
+        inline u64 traceNow() {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+        }
+
+        // one thread's events. only its thread writes, readers take whatever is behind the head. each slot is a
+        // seqlock: the writer marks it odd while it stores the event's words and even with the event index once
+        // done, a reader drops a slot whose sequence isn't the finished one of the event it wants or changed while
+        // it copied, so an export racing a busy writer loses the events being overwritten instead of tearing them.
+        class TraceBuffer {
+        public:
+            explicit TraceBuffer(u32 thread) : m_slots(LIB_IMG_TRACE_CAPACITY), m_thread(thread) {
+            }
+
+            void push(TraceEvent e) {
+                const u64 head = m_head.load(std::memory_order_relaxed);
+                e.thread       = m_thread;
+
+                std::array<u64, WORDS> words{};
+                std::memcpy(words.data(), &e, sizeof(e));
+
+                Slot& slot = m_slots[head & (LIB_IMG_TRACE_CAPACITY - 1)];
+                slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (u32 i = 0; i < WORDS; ++i) {
+                    slot.words[i].store(words[i], std::memory_order_relaxed);
+                }
+                slot.sequence.store(2 * head + 2, std::memory_order_release);
+                m_head.store(head + 1, std::memory_order_release);
+            }
+
+            void collect(std::vector<TraceEvent>& out) const {
+                const u64 head  = m_head.load(std::memory_order_acquire);
+                const u64 first = std::max(m_cleared.load(std::memory_order_relaxed),
+                                           head > LIB_IMG_TRACE_CAPACITY ? head - LIB_IMG_TRACE_CAPACITY : 0);
+                for (u64 i = first; i < head; ++i) {
+                    const Slot& slot     = m_slots[i & (LIB_IMG_TRACE_CAPACITY - 1)];
+                    const u64   sequence = slot.sequence.load(std::memory_order_acquire);
+                    if (sequence != 2 * i + 2) {
+                        continue;
+                    }
+
+                    std::array<u64, WORDS> words;
+                    for (u32 w = 0; w < WORDS; ++w) {
+                        words[w] = slot.words[w].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                        continue;
+                    }
+
+                    TraceEvent e;
+                    std::memcpy(&e, words.data(), sizeof(e));
+                    out.push_back(e);
+                }
+            }
+
+            // the writer is left alone, everything before the current head is skipped from now on.
+            void clear() {
+                m_cleared.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+            }
+
+        private:
+            static_assert(std::is_trivially_copyable_v<TraceEvent>);
+            static constexpr u32 WORDS = (sizeof(TraceEvent) + sizeof(u64) - 1) / sizeof(u64);
+
+            struct Slot {
+                std::atomic<u64>                    sequence{0};
+                std::array<std::atomic<u64>, WORDS> words{};
+            };
+
+            std::vector<Slot> m_slots;
+            std::atomic<u64>  m_head{0};
+            std::atomic<u64>  m_cleared{0};
+            u32               m_thread;
+        };
+
+        // every thread that ever traced, buffers outlive their threads so late exports still see them. leaked on
+        // purpose, threads can still trace while statics are destroyed at exit.
+        struct TraceRegistry {
+            std::mutex                                mutex;
+            std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+            static TraceRegistry& get() {
+                static auto* registry = new TraceRegistry;
+                return *registry;
+            }
+        };
+
+        inline TraceBuffer& threadTraceBuffer() {
+            thread_local TraceBuffer* buffer = [] {
+                TraceRegistry&  registry = TraceRegistry::get();
+                std::lock_guard lock{registry.mutex};
+                registry.buffers.push_back(std::make_unique<TraceBuffer>(static_cast<u32>(registry.buffers.size())));
+                return registry.buffers.back().get();
+            }();
+            return *buffer;
+        }
+
+        // times its own lifetime. the image is read when the scope closes, so loaders and operations that resize
+        // report what they produced.
+        class TraceScope {
+        public:
+            template<typename Img>
+            TraceScope(const char* name, const Img& image)
+                : m_name(name),
+                  m_image(&image),
+                  m_describe([](const void* p, TraceEvent& e) {
+                      const Img& img = *static_cast<const Img*>(p);
+                      e.format       = pixel_traits<typename Img::Pixel_t>::FORMAT;
+                      e.width        = img.width();
+                      e.height       = img.height();
+                      e.bytes        = u64{img.pixelCount()} * sizeof(typename Img::Pixel_t);
+                  }),
+                  m_start(traceNow()) {
+            }
+
+            TraceScope(const TraceScope&)            = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+
+            ~TraceScope() {
+                TraceEvent e{};
+                e.name   = m_name;
+                e.format = PF_UNKOWN;
+                e.start  = m_start;
+                m_describe(m_image, e);
+                e.duration = traceNow() - m_start;
+                threadTraceBuffer().push(e);
+            }
+
+        private:
+            const char* m_name;
+            const void* m_image;
+            void (*m_describe)(const void*, TraceEvent&);
+            u64 m_start;
+        };
+
+    } // namespace detail
+
+    // events recorded so far on every thread, oldest first per thread.
+    inline std::vector<TraceEvent> traceEvents() {
+        std::vector<TraceEvent> events;
+        detail::TraceRegistry&  registry = detail::TraceRegistry::get();
+        std::lock_guard         lock{registry.mutex};
+        for (const auto& buffer : registry.buffers) {
+            buffer->collect(events);
+        }
+        return events;
+    }
+
+    inline void clearTrace() {
+        detail::TraceRegistry& registry = detail::TraceRegistry::get();
+        std::lock_guard        lock{registry.mutex};
+        for (const auto& buffer : registry.buffers) {
+            buffer->clear();
+        }
+    }
+
+    // the recorded events in the Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev.
+    // timestamps are microseconds from the earliest event.
+    inline std::string chromeTraceJson() {
+        const std::vector<TraceEvent> events = traceEvents();
+
+        u64 origin = UINT64_MAX;
+        for (const TraceEvent& e : events) {
+            origin = std::min(origin, e.start);
+        }
+
+        std::string json = "{\"traceEvents\":[";
+        char        line[512];
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            const TraceEvent& e = events[i];
+            std::snprintf(line,
+                          sizeof(line),
+                          "%s\n{\"name\":\"%s\",\"cat\":\"libimg\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                          "\"dur\":%.3f,\"args\":{\"pixel\":\"%s\",\"width\":%u,\"height\":%u,\"bytes\":%llu}}",
+                          i ? "," : "",
+                          e.name,
+                          e.thread,
+                          static_cast<double>(e.start - origin) / 1000.0,
+                          static_cast<double>(e.duration) / 1000.0,
+                          pixelFmtName(e.format),
+                          e.width,
+                          e.height,
+                          static_cast<unsigned long long>(e.bytes));
+            json += line;
+        }
+        json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return json;
+    }
+
+    inline bool saveChromeTrace(const fs::path& filePath) {
+        FILE* f = fopen(filePath.c_str(), "wb");
+        if (!f) {
+            return false;
+        }
+
+        const std::string json = chromeTraceJson();
+        const bool        ok   = fwrite(json.data(), 1, json.size(), f) == json.size();
+        return (fclose(f) == 0) && ok;
+    }
+
+} // namespace img
+
+// `IMG_TRACE_SCOPE(name, image)` traces the rest of the enclosing scope against `image`, whose pixel type and size
+// are read when the scope ends. `name` has to be a string literal.
+#if LIB_IMG_TRACE
+    #define IMG_TRACE_CONCAT_(a, b) a##b
+    #define IMG_TRACE_CONCAT(a, b)  IMG_TRACE_CONCAT_(a, b)
+    #define IMG_TRACE_SCOPE(name, image) \
+        const ::img::detail::TraceScope IMG_TRACE_CONCAT(imgTraceScope_, __LINE__)((name), (image))
+#else
+    #define IMG_TRACE_SCOPE(name, image)
+#endif
+
+#endif // LIB_IMG_TRACE_H
@@ -37,16 +37,25 @@ namespace img {
     concept is_pixel_type
         = std::is_same_v<T, struct GREY8> || std::is_same_v<T, struct GREYa8> || std::is_same_v<T, struct RGB8>
           || std::is_same_v<T, struct RGBa8> || std::is_same_v<T, struct BGR8> || std::is_same_v<T, struct BGRa8>
-          || std::is_same_v<T, struct HDR32>;
+          || std::is_same_v<T, struct HDR32> || std::is_same_v<T, struct HDRa32> || std::is_same_v<T, struct GREY16>
+          || std::is_same_v<T, struct GREYa16> || std::is_same_v<T, struct RGB16> || std::is_same_v<T, struct RGBa16>;
 
     template<typename T>
     concept is_color_8_bit_depth
         = std::is_same_v<T, struct GREY8> || std::is_same_v<T, struct GREYa8> || std::is_same_v<T, struct RGB8>
-          || std::is_same_v<T, struct RGBa8> || std::is_same_v<T, struct BGR8> || std::is_same_v<T, struct BGRa8>
-          || std::is_same_v<T, struct HDR32>;
+          || std::is_same_v<T, struct RGBa8> || std::is_same_v<T, struct BGR8> || std::is_same_v<T, struct BGRa8>;
+
+    template<typename T>
+    concept is_color_16_bit_depth = std::is_same_v<T, struct GREY16> || std::is_same_v<T, struct GREYa16>
+                                 || std::is_same_v<T, struct RGB16> || std::is_same_v<T, struct RGBa16>;
+
+    // linear light RGB(A) in 32-bit floats, values aren't limited to [0, 1].
+    template<typename T>
+    concept is_hdr_pixel = std::is_same_v<T, struct HDR32> || std::is_same_v<T, struct HDRa32>;
 
     template<typename T>
-    concept is_grey_scale_pixel = std::is_same_v<T, struct GREY8> || std::is_same_v<T, struct GREYa8>;
+    concept is_grey_scale_pixel = std::is_same_v<T, struct GREY8> || std::is_same_v<T, struct GREYa8>
+                               || std::is_same_v<T, struct GREY16> || std::is_same_v<T, struct GREYa16>;
 
     template<typename T>
     concept is_1_channel_pixel = std::is_same_v<T, struct GREY8>;
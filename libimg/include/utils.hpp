@@ -3,6 +3,7 @@
 
 #include "common.hpp"
 #include "img_assert.hpp"
+#include "pixel_traits.hpp"
 #include "types.hpp"
 
 namespace img {
@@ -25,13 +26,15 @@ namespace img {
         return clamp<T, u8>(n, 0, 255);
     }
 
+    // `value` converted to a channel of `Pixel`, saturated to the channel range except for float channels.
     template<typename Pixel, typename T>
     auto clampColorChanel(const T value) {
-        if constexpr (is_color_8_bit_depth<Pixel>) {
-            return clamp<T, u8>(value, 0, 255);
+        using Channel_t = pixel_channel_t<Pixel>;
+        if constexpr (std::is_floating_point_v<Channel_t>) {
+            return static_cast<Channel_t>(value);
+        } else {
+            return clamp<T, Channel_t>(value, 0, pixel_traits<Pixel>::MAX);
         }
-
-        UNREACHABLE();
     }
 
 } // namespace img
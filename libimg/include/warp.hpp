@@ -0,0 +1,204 @@
+#ifndef LIB_IMG_WARP_H
+#define LIB_IMG_WARP_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <type_traits>
+
+#include "border.hpp"
+#include "common.hpp"
+#include "img_assert.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+namespace img {
+
+    enum Interpolation : u8 {
+        IP_NEAREST  = 0,
+        IP_BILINEAR = 1,
+    };
+
+    // x' = m[0] x + m[1] y + m[2], y' = m[3] x + m[4] y + m[5], maps source pixel coordinates to destination
+    // ones, pixel centres sit on integer coordinates.
+    struct AffineTransform {
+        std::array<double, 6> m;
+
+        // counter-clockwise as displayed (y points down) around (centerX, centerY).
+        static AffineTransform rotation(double degrees, double centerX, double centerY, double scale = 1.0) {
+            const double rad = degrees * std::numbers::pi / 180.0;
+            const double a   = scale * std::cos(rad);
+            const double b   = scale * std::sin(rad);
+            return {{a, b, (1 - a) * centerX - b * centerY, -b, a, b * centerX + (1 - a) * centerY}};
+        }
+
+        AffineTransform inverted() const {
+            const double det = m[0] * m[4] - m[1] * m[3];
+            IMG_ASSERT(det != 0.0, "affine transform is not invertible");
+
+            const double a = m[4] / det, b = -m[1] / det, d = -m[3] / det, e = m[0] / det;
+            return {{a, b, -(a * m[2] + b * m[5]), d, e, -(d * m[2] + e * m[5])}};
+        }
+    };
+
+    // row-major 3x3 homography on (x, y, 1), same coordinate convention as `AffineTransform`.
+    struct PerspectiveTransform {
+        std::array<double, 9> m;
+
+        PerspectiveTransform inverted() const {
+            const double c00 = m[4] * m[8] - m[5] * m[7];
+            const double c01 = m[5] * m[6] - m[3] * m[8];
+            const double c02 = m[3] * m[7] - m[4] * m[6];
+            const double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+            IMG_ASSERT(det != 0.0, "perspective transform is not invertible");
+
+            return {{
+                c00 / det,
+                (m[2] * m[7] - m[1] * m[8]) / det,
+                (m[1] * m[5] - m[2] * m[4]) / det,
+                c01 / det,
+                (m[0] * m[8] - m[2] * m[6]) / det,
+                (m[2] * m[3] - m[0] * m[5]) / det,
+                c02 / det,
+                (m[1] * m[6] - m[0] * m[7]) / det,
+                (m[0] * m[4] - m[1] * m[3]) / det,
+            }};
+        }
+    };
+
+} // namespace img
+
+namespace img::detail {
+
+    // output is produced in square tiles, the source footprint of a tile stays small for any rotation.
+    constexpr u32 WARP_TILE = 64;
+
+    // source coordinates are 48.16 fixed point, bilinear weights use the top 8 fractional bits.
+    constexpr i64 WARP_ONE = i64{1} << 16;
+
+    // far enough outside any image to hit the border path, small enough not to overflow once scaled.
+    constexpr double WARP_COORD_LIMIT = 1e9;
+
+    inline i64 toWarpFixed(double v) {
+        return std::llround(std::clamp(v, -WARP_COORD_LIMIT, WARP_COORD_LIMIT) * WARP_ONE);
+    }
+
+    template<u32 C, Interpolation IP>
+    void warpSample(const BorderedView& s, u8* out, i64 u, i64 v) {
+        if constexpr (IP == IP_NEAREST) {
+            const i64 x = (u + WARP_ONE / 2) >> 16;
+            const i64 y = (v + WARP_ONE / 2) >> 16;
+
+            const u8* p = s.at(x, y);
+            for (u32 c = 0; c < C; ++c) {
+                out[c] = p[c];
+            }
+        } else {
+            const i64 x  = u >> 16;
+            const i64 y  = v >> 16;
+            const i32 fx = static_cast<i32>((u >> 8) & 0xFF);
+            const i32 fy = static_cast<i32>((v >> 8) & 0xFF);
+
+            const u8 *p00, *p01, *p10, *p11;
+            if (static_cast<u64>(x) < u64{s.width} - 1 && static_cast<u64>(y) < u64{s.height} - 1) {
+                p00 = s.data + (y * s.width + x) * C;
+                p01 = p00 + C;
+                p10 = p00 + std::size_t{s.width} * C;
+                p11 = p10 + C;
+            } else {
+                p00 = s.at(x, y);
+                p01 = s.at(x + 1, y);
+                p10 = s.at(x, y + 1);
+                p11 = s.at(x + 1, y + 1);
+            }
+
+            for (u32 c = 0; c < C; ++c) {
+                const i32 top    = (p00[c] << 8) + (p01[c] - p00[c]) * fx;
+                const i32 bottom = (p10[c] << 8) + (p11[c] - p10[c]) * fx;
+                out[c]           = static_cast<u8>(((top << 8) + (bottom - top) * fy + (1 << 15)) >> 16);
+            }
+        }
+    }
+
+    // `inverse` maps destination pixels back into the source. source coordinates are stepped incrementally along
+    // each tile row: affine adds a constant fixed point delta, perspective steps the homogeneous numerators and
+    // denominator and divides once per pixel.
+    template<u32 C, Interpolation IP, typename Transform>
+    void warpTiles(const BorderedView& s, u8* dst, u32 width, u32 height, const Transform& inverse) {
+        const u32 tilesX = (width + WARP_TILE - 1) / WARP_TILE;
+        const u32 tilesY = (height + WARP_TILE - 1) / WARP_TILE;
+        const auto& m    = inverse.m;
+
+        parallelFor(0, tilesX * tilesY, 1, [&](u32 t0, u32 t1) {
+            for (u32 t = t0; t < t1; ++t) {
+                const u32 x0 = (t % tilesX) * WARP_TILE, x1 = std::min(width, x0 + WARP_TILE);
+                const u32 y0 = (t / tilesX) * WARP_TILE, y1 = std::min(height, y0 + WARP_TILE);
+
+                for (u32 y = y0; y < y1; ++y) {
+                    u8* out = dst + (std::size_t{y} * width + x0) * C;
+
+                    if constexpr (std::is_same_v<Transform, AffineTransform>) {
+                        const i64 du = toWarpFixed(m[0]), dv = toWarpFixed(m[3]);
+                        i64       u  = toWarpFixed(m[0] * x0 + m[1] * y + m[2]);
+                        i64       v  = toWarpFixed(m[3] * x0 + m[4] * y + m[5]);
+                        for (u32 x = x0; x < x1; ++x, out += C, u += du, v += dv) {
+                            warpSample<C, IP>(s, out, u, v);
+                        }
+                    } else {
+                        double px = m[0] * x0 + m[1] * y + m[2];
+                        double py = m[3] * x0 + m[4] * y + m[5];
+                        double pw = m[6] * x0 + m[7] * y + m[8];
+                        for (u32 x = x0; x < x1; ++x, out += C, px += m[0], py += m[3], pw += m[6]) {
+                            i64 u = toWarpFixed(-WARP_COORD_LIMIT), v = u;
+                            if (pw != 0.0) {
+                                const double rw = 1.0 / pw;
+                                u               = toWarpFixed(px * rw);
+                                v               = toWarpFixed(py * rw);
+                            }
+                            warpSample<C, IP>(s, out, u, v);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    template<u32 C, typename Transform>
+    void warpChannels(const BorderedView& s, u8* dst, u32 width, u32 height, const Transform& inverse,
+                      Interpolation ip) {
+        if (ip == IP_NEAREST) {
+            warpTiles<C, IP_NEAREST>(s, dst, width, height, inverse);
+        } else {
+            warpTiles<C, IP_BILINEAR>(s, dst, width, height, inverse);
+        }
+    }
+
+    template<typename Transform>
+    void warp(const BorderedView& s, u32 channels, u8* dst, u32 width, u32 height, const Transform& inverse,
+              Interpolation ip) {
+        // an empty source has nothing to sample and no border to index into, every destination pixel is the
+        // constant with BM_CONSTANT and black with the other modes.
+        if (s.width == 0 || s.height == 0) {
+            const std::size_t n = std::size_t{width} * height;
+            if (s.mode == BM_CONSTANT) {
+                fillPixels(dst, s.constant, n, channels);
+            } else {
+                std::memset(dst, 0, n * channels);
+            }
+            return;
+        }
+
+        switch (channels) {
+            case 1: warpChannels<1>(s, dst, width, height, inverse, ip); break;
+            case 2: warpChannels<2>(s, dst, width, height, inverse, ip); break;
+            case 3: warpChannels<3>(s, dst, width, height, inverse, ip); break;
+            case 4: warpChannels<4>(s, dst, width, height, inverse, ip); break;
+            default: IMG_ABORT("unsupported channel count: %u", channels);
+        }
+    }
+
+} // namespace img::detail
+
+#endif // LIB_IMG_WARP_H
@@ -0,0 +1,86 @@
+#include <atomic>
+#include <cstdlib>
+#include <libimg>
+#include <new>
+
+#include "check.hpp"
+
+using namespace img;
+
+// every heap allocation in the process goes through here.
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// heap allocations made by `fn()`.
+template<typename Fn>
+long allocationsOf(Fn&& fn) {
+    const long before = allocations.load();
+    fn();
+    return allocations.load() - before;
+}
+
+int main() {
+    const u32 W = 64, H = 48;
+
+    // one-time state: the shared pool's threads, the memory counters and the recycled `parallelFor` states.
+    Image<RGB8>   warm{W, H};
+    Image<GREY8>  warmGrey{W, H};
+    Image<RGB8>   warmSum{W, H};
+    Image<RGB8>::add(warm, warm, warmSum);
+    warm.greyScaleLum(warmGrey);
+
+    // construction and copies allocate the pixels and nothing else, moves allocate nothing.
+    Image<RGB8> a{W, H};
+    CHECK(allocationsOf([&] { Image<RGB8> b{W, H}; }) == 1);
+    CHECK(allocationsOf([&] { Image<RGB8> b{W, H, RGB8{}}; }) == 1);
+    CHECK(allocationsOf([&] { Image<RGB8> b{a}; }) == 1);
+    CHECK(allocationsOf([&] { Image<RGB8> b{std::move(a)}; a = std::move(b); }) == 0);
+    CHECK(allocationsOf([&] { Image<RGB8> sum = a + a; }) == 1);
+    CHECK(allocationsOf([&] { Image<GREY8> grey = a.greyScaleLum(); }) == 1);
+
+    // the in-place and destination paths allocate nothing at all.
+    Image<RGB8>  b{W, H};
+    Image<RGB8>  dst{W, H};
+    Image<GREY8> grey{W, H};
+    CHECK(allocationsOf([&] { b = a; }) == 0);
+    CHECK(allocationsOf([&] { Image<RGB8>::add(a, b, dst); }) == 0);
+    CHECK(allocationsOf([&] { Image<RGB8>::subtract(a, b, dst); }) == 0);
+    CHECK(allocationsOf([&] { a.greyScaleLum(grey); }) == 0);
+    CHECK(allocationsOf([&] { a.greyScaleAvg(grey); }) == 0);
+    CHECK(allocationsOf([&] { a.flipX().flipY(); }) == 0);
+    CHECK(allocationsOf([&] { a.rotateLeft().rotateRight(); }) == 0);
+    CHECK(allocationsOf([&] { ~a; }) == 0);
+    CHECK(allocationsOf([&] { b.cropZeroBased(0, 0, W / 2, H / 2); }) == 0);
+
+    if (checkFailures()) {
+        std::fprintf(stderr, "%d checks failed\n", checkFailures());
+    }
+    return checkFailures();
+}
@@ -0,0 +1,21 @@
+#ifndef LIB_IMG_TESTS_CHECK_H
+#define LIB_IMG_TESTS_CHECK_H
+
+#include <cstdio>
+
+// `assert` is compiled out of release builds, the tests report through this instead and keep going, `main`
+// returns `checkFailures()` as its exit code.
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                            \
+    do {                                                                                       \
+        if (!(cond)) {                                                                         \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+            ++checkFailures();                                                                 \
+        }                                                                                      \
+    } while (0)
+
+#endif // LIB_IMG_TESTS_CHECK_H
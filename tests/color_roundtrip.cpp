@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstdlib>
+#include <libimg>
+
+#include "check.hpp"
+
+using namespace img;
+
+// every 8-bit rgb colour once, r in the high byte of the pixel index.
+template<typename Pixel>
+Image<Pixel> rgbCube() {
+    Image<Pixel> cube{4096, 4096};
+    for (u32 i = 0; i < 1u << 24; ++i) {
+        cube[i].r = static_cast<u8>(i >> 16);
+        cube[i].g = static_cast<u8>(i >> 8);
+        cube[i].b = static_cast<u8>(i);
+    }
+    return cube;
+}
+
+// largest per-channel difference to the cube after `there()` and `back()`.
+template<typename Pixel, typename There, typename Back>
+int roundTripError(There&& there, Back&& back) {
+    Image<Pixel> img = rgbCube<Pixel>();
+    there(img);
+    back(img);
+
+    int worst = 0;
+    for (u32 i = 0; i < 1u << 24; ++i) {
+        worst = std::max({worst,
+                          std::abs(img[i].r - static_cast<int>((i >> 16) & 0xFF)),
+                          std::abs(img[i].g - static_cast<int>((i >> 8) & 0xFF)),
+                          std::abs(img[i].b - static_cast<int>(i & 0xFF))});
+    }
+    return worst;
+}
+
+// the bounds documented next to the converters in color.hpp, checked for both channel orders.
+template<typename Pixel>
+void checkRoundTrips() {
+    for (YCbCrMatrix matrix : {YCC_BT601, YCC_BT709}) {
+        CHECK(roundTripError<Pixel>([&](auto& img) { img.rgbToYCbCr(matrix, YCC_FULL_RANGE); },
+                                    [&](auto& img) { img.yCbCrToRgb(matrix, YCC_FULL_RANGE); }) <= 1);
+        CHECK(roundTripError<Pixel>([&](auto& img) { img.rgbToYCbCr(matrix, YCC_LIMITED_RANGE); },
+                                    [&](auto& img) { img.yCbCrToRgb(matrix, YCC_LIMITED_RANGE); }) <= 2);
+    }
+    CHECK(roundTripError<Pixel>([](auto& img) { img.rgbToHsv(); }, [](auto& img) { img.hsvToRgb(); }) <= 3);
+    CHECK(roundTripError<Pixel>([](auto& img) { img.rgbToHsl(); }, [](auto& img) { img.hslToRgb(); }) <= 4);
+    CHECK(roundTripError<Pixel>([](auto& img) { img.rgbToLab(); }, [](auto& img) { img.labToRgb(); }) <= 26);
+}
+
+int main() {
+    checkRoundTrips<RGB8>();
+    checkRoundTrips<BGR8>();
+
+    // grey stays grey through every space.
+    Image<RGB8> grey{256, 1};
+    for (u32 i = 0; i < 256; ++i) {
+        grey[i].r = grey[i].g = grey[i].b = static_cast<u8>(i);
+    }
+    Image<RGB8> hsv = grey;
+    hsv.rgbToHsv().hsvToRgb();
+    Image<RGB8> hsl = grey;
+    hsl.rgbToHsl().hslToRgb();
+    Image<RGB8> ycc = grey;
+    ycc.rgbToYCbCr().yCbCrToRgb();
+    for (u32 i = 0; i < 256; ++i) {
+        CHECK(hsv[i].r == i && hsv[i].g == i && hsv[i].b == i);
+        CHECK(hsl[i].r == i && hsl[i].g == i && hsl[i].b == i);
+        CHECK(ycc[i].r == i && ycc[i].g == i && ycc[i].b == i);
+    }
+
+    if (checkFailures()) {
+        std::fprintf(stderr, "%d checks failed\n", checkFailures());
+    }
+    return checkFailures();
+}
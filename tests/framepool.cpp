@@ -0,0 +1,66 @@
+#include <libimg>
+
+#include "check.hpp"
+
+using namespace img;
+
+// pixel buffers allocated by `fn()`.
+template<typename Fn>
+u64 pixelAllocationsOf(Fn&& fn) {
+    const u64 before = memoryStats().allocations;
+    fn();
+    return memoryStats().allocations - before;
+}
+
+int main() {
+    const u32 W = 64, H = 48;
+
+    Image<RGB8> a{W, H};
+
+    // a frame pool stops allocating once it holds as many frames as are ever out at once.
+    FramePool<RGB8> pool{W, H, 2};
+    auto            step = [&] {
+        auto f = pool.acquire();
+        auto g = pool.acquire();
+        Image<RGB8>::add(*f, a, *g);
+    };
+    step();
+    CHECK(pixelAllocationsOf([&] {
+              for (u32 i = 0; i < 100; ++i) {
+                  step();
+              }
+          }) == 0);
+    CHECK(pool.stats().allocations == 2 && pool.stats().acquires == 202);
+
+    // a pending quarter turn is dropped, not applied, and the frame still fits.
+    CHECK(pixelAllocationsOf([&] {
+              for (u32 i = 0; i < 100; ++i) {
+                  auto f = pool.acquire();
+                  f->rotateRight().flipX();
+              }
+          }) == 0);
+    CHECK(pool.stats().allocations == 2 && pool.stats().idle == 2);
+
+    // frames an operation resized are dropped and replaced.
+    {
+        auto f = pool.acquire();
+        f->pad(1, 1, 1, 1, BM_CONSTANT);
+    }
+    CHECK(pool.stats().idle == 1);
+
+    // a frame the budget refuses is a null frame and isn't counted.
+    setMemoryBudget(memoryStats().liveBytes);
+    {
+        auto f = pool.acquire();
+        auto g = pool.acquire();
+        CHECK(!f.isNull() && g.isNull());
+        CHECK(pool.stats().inUse == 1 && pool.stats().allocations == 2);
+    }
+    setMemoryBudget(0);
+    CHECK(pool.stats().inUse == 0);
+
+    if (checkFailures()) {
+        std::fprintf(stderr, "%d checks failed\n", checkFailures());
+    }
+    return checkFailures();
+}